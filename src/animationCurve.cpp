@@ -1,6 +1,8 @@
 
 #include "animationCurve.h"
 #include "fbxdocument.h"
+#include <cmath>
+#include <algorithm>
 
 using namespace fbx;
 
@@ -12,6 +14,7 @@ struct AnimationCurveImpl : AnimationCurve
 	AnimationCurveImpl(int64_t id)
 		: AnimationCurve(id)
 	{
+		SetOwnTimes(std::vector<i64>());
 	}
 
 	double Evaluate(const OFBTime& time) const override
@@ -29,16 +32,17 @@ struct AnimationCurveImpl : AnimationCurve
 
 			if (count > 0)
 			{
+				const std::vector<i64>& times = *m_Times;
 				i64 fbx_time(time.Get());
 
-				if (fbx_time < m_Times[0]) fbx_time = m_Times[0];
-				if (fbx_time > m_Times[count - 1]) fbx_time = m_Times[count - 1];
+				if (fbx_time < times[0]) fbx_time = times[0];
+				if (fbx_time > times[count - 1]) fbx_time = times[count - 1];
 
 				for (size_t i = 1; i < count; ++i)
 				{
-					if (m_Times[i] >= fbx_time)
+					if (times[i] >= fbx_time)
 					{
-						float t = float(double(fbx_time - m_Times[i - 1]) / double(m_Times[i] - m_Times[i - 1]));
+						float t = float(double(fbx_time - times[i - 1]) / double(times[i] - times[i - 1]));
 						result = m_Values[i - 1] * (1 - t) + m_Values[i] * t;
 						break;
 					}
@@ -58,14 +62,16 @@ struct AnimationCurveImpl : AnimationCurve
 		}
 	}
 
-	int getKeyCount() const override { return (int)m_Times.size(); }
-	const i64* getKeyTime() const override { return &m_Times[0]; }
+	int getKeyCount() const override { return (int)m_Times->size(); }
+	const i64* getKeyTime() const override { return m_Times->data(); }
 	const float* getKeyValue() const override { return &m_Values[0]; }
 	const int* getKeyFlag() const override { return &m_Flags[0]; }
 
+	float* getKeyValue() override { return m_Values.data(); }
+
 	void SetKeyCount(const int count) override
 	{
-		m_Times.resize(count);
+		MutableTimes().resize(count);
 		m_Values.resize(count);
 		//m_Flags.resize(count);
 		SetKeyLinearFlags();
@@ -73,11 +79,66 @@ struct AnimationCurveImpl : AnimationCurve
 
 	void SetKey(int index, const OFBTime& time, const float value, const int flags) override
 	{
-		m_Times[index] = time.Get();
+		MutableTimes()[index] = time.Get();
 		m_Values[index] = value;
 		//m_Flags[index] = flags;
 	}
 
+	KeyTimeBuffer GetKeyTimeBuffer() const override { return m_Times; }
+
+	void ShareKeyTimes(const KeyTimeBuffer& times) override
+	{
+		if (times == nullptr)
+		{
+			SetOwnTimes(std::vector<i64>());
+		}
+		else
+		{
+			m_Times = times;
+			m_IsOwnTimes = false;
+		}
+		m_Values.resize(m_Times->size());
+		SetKeyLinearFlags();
+		m_LastEvalTime = OFBTime::MinusInfinity;
+	}
+
+	void SetKeys(const i64* times, const float* values, const int count) override
+	{
+		SetOwnTimes(std::vector<i64>(times, times + count));
+		m_Values.assign(values, values + count);
+		SetKeyLinearFlags();
+		m_LastEvalTime = OFBTime::MinusInfinity;
+	}
+
+	bool SetKeys(std::vector<i64>&& times, std::vector<float>&& values) override
+	{
+		if (times.size() != values.size())
+		{
+			printf("Animation curve keys are not set, %zu times and %zu values\n", times.size(), values.size());
+			return false;
+		}
+
+		SetOwnTimes(std::move(times));
+		m_Values = std::move(values);
+		SetKeyLinearFlags();
+		m_LastEvalTime = OFBTime::MinusInfinity;
+		return true;
+	}
+
+	bool SetKeys(const KeyTimeBuffer& times, std::vector<float>&& values) override
+	{
+		const size_t count = (times != nullptr) ? times->size() : 0;
+		if (count != values.size())
+		{
+			printf("Animation curve keys are not set, %zu times and %zu values\n", count, values.size());
+			return false;
+		}
+
+		ShareKeyTimes(times);
+		m_Values = std::move(values);
+		return true;
+	}
+
 	void SetKeyFlags(const std::vector<int32_t>&& flags)
 	{
 		m_Flags = flags;
@@ -99,7 +160,87 @@ struct AnimationCurveImpl : AnimationCurve
 		m_Flags = std::vector<int32_t>(1, 2);
 	}
 
-	std::vector<i64>		m_Times;
+	int ReduceKeys(const double tolerance) override
+	{
+		const size_t count = m_Values.size();
+		// flags per key are not reduced
+		if (count < 3 || m_Times->size() != count || m_Flags.size() > 1)
+			return 0;
+
+		const std::vector<i64>& times = *m_Times;
+
+		std::vector<uint8_t> keep(count, 0);
+		keep[0] = 1;
+		keep[count - 1] = 1;
+
+		if (!m_Flags.empty() && (m_Flags[0] & eInterpolationConstant) != 0)
+		{
+			// the value holds until the next key, only changes matter
+			for (size_t i = 1; i < count - 1; ++i)
+				keep[i] = (m_Values[i] != m_Values[i - 1]) ? 1 : 0;
+		}
+		else
+		{
+			// both the original and the reduced curves are linear between keys, so the largest error
+			// between them is at one of the original keys, the error is measured as Evaluate interpolates
+			std::vector<std::pair<size_t, size_t>> segments(1, std::make_pair(static_cast<size_t>(0), count - 1));
+			while (!segments.empty())
+			{
+				const size_t first = segments.back().first;
+				const size_t last = segments.back().second;
+				segments.pop_back();
+
+				const double duration = double(times[last] - times[first]);
+				double maxError = tolerance;
+				size_t split = 0;
+
+				for (size_t i = first + 1; i < last; ++i)
+				{
+					const float t = (duration > 0.0) ? float(double(times[i] - times[first]) / duration) : 0.0f;
+					const float value = m_Values[first] * (1 - t) + m_Values[last] * t;
+					const double error = std::abs(double(value) - double(m_Values[i]));
+
+					if (error > maxError)
+					{
+						maxError = error;
+						split = i;
+					}
+				}
+
+				if (split > 0)
+				{
+					keep[split] = 1;
+					segments.emplace_back(first, split);
+					segments.emplace_back(split, last);
+				}
+			}
+		}
+
+		// a reduced curve gets own key times, a curve without removed keys keeps sharing them
+		std::vector<i64> keptTimes;
+		size_t kept = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (keep[i])
+			{
+				keptTimes.push_back(times[i]);
+				m_Values[kept] = m_Values[i];
+				++kept;
+			}
+		}
+
+		if (kept < count)
+		{
+			SetOwnTimes(std::move(keptTimes));
+			m_Values.resize(kept);
+		}
+
+		m_LastEvalTime = OFBTime::MinusInfinity;
+		return static_cast<int>(count - kept);
+	}
+
+	KeyTimeBuffer			m_Times;
+	bool					m_IsOwnTimes{ true };	//!< the buffer is created by the curve and can be modified when it's not shared
 	std::vector<float>		m_Values;
 	std::vector<int32_t>	m_Flags;
 
@@ -121,8 +262,9 @@ struct AnimationCurveImpl : AnimationCurve
 			const FBXProperty& prop = times->getProperties().at(0);
 			if (prop.GetType() == FBXProperty::ARRAY_LONG)
 			{
-				m_Times.resize(prop.GetCount());
-				prop.GetData(m_Times.data());
+				std::vector<i64> keyTimes(prop.GetCount());
+				prop.GetData(keyTimes.data());
+				SetOwnTimes(std::move(keyTimes));
 			}
 			else printf("Invalid animation curve, times property!\n");
 		}
@@ -158,7 +300,7 @@ struct AnimationCurveImpl : AnimationCurve
 			}
 		}
 
-		if (m_Times.size() != m_Values.size())
+		if (m_Times->size() != m_Values.size())
 		{
 			printf("Invalid animation curve\n");
 		}
@@ -174,7 +316,7 @@ struct AnimationCurveImpl : AnimationCurve
 
 		element.addPropertyNode("Default", 0.0f);
 		element.addPropertyNode("KeyVer", 4009);
-		element.addPropertyNode("KeyTime", m_Times);
+		element.addPropertyNode("KeyTime", *m_Times);
 		element.addPropertyNode("KeyValueFloat", m_Values);
 
 		// ; KeyAttrFlags: Cubic | TangeantAuto 264
@@ -189,6 +331,24 @@ struct AnimationCurveImpl : AnimationCurve
 
 private:
 	AnimationCurveNode* m_Owner{ nullptr };
+
+	void SetOwnTimes(std::vector<i64>&& times)
+	{
+		m_Times = std::make_shared<std::vector<i64>>(std::move(times));
+		m_IsOwnTimes = true;
+	}
+
+	/// <summary>
+	/// copy on write of the key times, a shared buffer is copied before a modification
+	/// </summary>
+	std::vector<i64>& MutableTimes()
+	{
+		if (!m_IsOwnTimes || m_Times.use_count() > 1)
+			SetOwnTimes(std::vector<i64>(*m_Times));
+
+		// own buffers are created as not const, see SetOwnTimes
+		return const_cast<std::vector<i64>&>(*m_Times);
+	}
 };
 
 AnimationCurve::AnimationCurve(int64_t id)
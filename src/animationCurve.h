@@ -2,6 +2,8 @@
 
 #include "fbxnode.h"
 #include "fbxobject.h"
+#include <vector>
+#include <memory>
 
 namespace fbx
 {
@@ -78,6 +80,11 @@ namespace fbx
 		eTCBBias = 2			//!< Index of Bias, TCB tangent mode.
 	};
 
+	/// <summary>
+	/// key times shared by curves of one take, a curve never modifies a shared buffer, it makes own copy first
+	/// </summary>
+	typedef std::shared_ptr<const std::vector<i64>>	KeyTimeBuffer;
+
 	/// <summary>
 	/// a container that holds animation curve data (time, values and flags)
 	/// </summary>
@@ -97,12 +104,53 @@ namespace fbx
 		virtual const float* getKeyValue() const = 0;
 		virtual const int* getKeyFlag() const = 0;
 
+		/// <summary>
+		/// writable values of the keys, a batch of values is filled directly after SetKeyCount
+		/// </summary>
+		virtual float* getKeyValue() = 0;
+
 		virtual void SetKeyCount(const int count) = 0;
 		virtual void SetKey(int index, const OFBTime& time, const float value, const int flags=0) = 0;
 
+		/// <summary>
+		/// buffer of the key times, it can be shared with other curves, see ShareKeyTimes
+		/// </summary>
+		virtual KeyTimeBuffer GetKeyTimeBuffer() const = 0;
+
+		/// <summary>
+		/// keys get the times of a shared buffer, values are resized to the number of times
+		/// and are filled with getKeyValue(), key flags are linear like after SetKeyCount
+		/// </summary>
+		virtual void ShareKeyTimes(const KeyTimeBuffer& times) = 0;
+
+		/// <summary>
+		/// set all keys from contiguous arrays of times and values, key flags are linear like after SetKeyCount
+		/// </summary>
+		virtual void SetKeys(const i64* times, const float* values, const int count) = 0;
+
+		/// <summary>
+		/// take prefilled arrays of the same size as all keys, key flags are linear like after SetKeyCount
+		/// </summary>
+		/// <returns>false and the curve is not changed when the arrays have different sizes</returns>
+		virtual bool SetKeys(std::vector<i64>&& times, std::vector<float>&& values) = 0;
+
+		/// <summary>
+		/// set all keys with times of a shared buffer and prefilled values, see ShareKeyTimes
+		/// </summary>
+		/// <returns>false and the curve is not changed when the values don't match the times</returns>
+		virtual bool SetKeys(const KeyTimeBuffer& times, std::vector<float>&& values) = 0;
+
 		virtual void SetKeyLinearFlags() = 0;
 		virtual void SetKeyConstFlags() = 0;
 
+		/// <summary>
+		/// remove keys the curve can interpolate from the kept keys
+		///  a linear curve is simplified with Ramer-Douglas-Peucker, Evaluate of the result differs from
+		/// the original curve by no more than the tolerance; a constant curve keeps only value changes
+		/// </summary>
+		/// <returns>number of removed keys</returns>
+		virtual int ReduceKeys(const double tolerance) = 0;
+
 		virtual double Evaluate(const OFBTime& time) const = 0;
 
 	};
@@ -0,0 +1,280 @@
+#include "batchJobs.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <dirent.h>
+#endif
+
+namespace
+{
+	bool IsPathSeparator(const char c)
+	{
+		return c == '/' || c == '\\';
+	}
+
+	bool HasExtension(const std::string& filename, const char* extension)
+	{
+		const size_t length = strlen(extension);
+		if (filename.size() < length)
+			return false;
+
+		const char* tail = filename.c_str() + filename.size() - length;
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (tolower(static_cast<unsigned char>(tail[i])) != tolower(static_cast<unsigned char>(extension[i])))
+				return false;
+		}
+		return true;
+	}
+
+	// extensions of archived recordings
+	const char* const COMPRESSED_EXTENSIONS[] = { ".gz", ".zip" };
+
+	// file name without a directory and an extension, an archive keeps its suffix,
+	//  take.cgi gives take, take.cgi.gz gives take.gz and take.zip gives take.zip
+	std::string GetBaseName(const std::string& path)
+	{
+		size_t first = path.size();
+		while (first > 0 && !IsPathSeparator(path[first - 1]))
+			--first;
+
+		std::string name = path.substr(first);
+		std::string archive;
+		for (const char* extension : COMPRESSED_EXTENSIONS)
+		{
+			if (HasExtension(name, extension))
+			{
+				archive = name.substr(name.size() - strlen(extension));
+				name.resize(name.size() - archive.size());
+				break;
+			}
+		}
+
+		const size_t dot = name.rfind('.');
+		return ((dot != std::string::npos && dot > 0) ? name.substr(0, dot) : name) + archive;
+	}
+
+	// output files are compared case insensitive on Windows
+	std::string GetOutputKey(const std::string& filename)
+	{
+		std::string key(filename);
+#ifdef _WIN32
+		for (char& c : key)
+		{
+			c = (c == '/') ? '\\' : static_cast<char>(tolower(static_cast<unsigned char>(c)));
+		}
+#endif
+		return key;
+	}
+
+	std::string GetDirectory(const std::string& path)
+	{
+		size_t last = path.size();
+		while (last > 0 && !IsPathSeparator(path[last - 1]))
+			--last;
+		return path.substr(0, last);
+	}
+
+	std::string JoinPath(const std::string& directory, const std::string& filename)
+	{
+		if (directory.empty() || IsPathSeparator(directory.back()))
+			return directory + filename;
+		return directory + "/" + filename;
+	}
+
+	// split a manifest line into tokens, a token in quotes can have spaces
+	std::vector<std::string> SplitManifestLine(const std::string& line)
+	{
+		std::vector<std::string> tokens;
+		size_t pos = 0;
+
+		while (pos < line.size())
+		{
+			while (pos < line.size() && isspace(static_cast<unsigned char>(line[pos])))
+				++pos;
+			if (pos >= line.size())
+				break;
+
+			if (line[pos] == '"')
+			{
+				const size_t quote = line.find('"', pos + 1);
+				const size_t last = (quote != std::string::npos) ? quote : line.size();
+				tokens.push_back(line.substr(pos + 1, last - pos - 1));
+				pos = last + 1;
+			}
+			else
+			{
+				const size_t first = pos;
+				while (pos < line.size() && !isspace(static_cast<unsigned char>(line[pos])))
+					++pos;
+				tokens.push_back(line.substr(first, pos - first));
+			}
+		}
+		return tokens;
+	}
+
+	bool ParseNumber(const std::string& token, double& value)
+	{
+		char* end = nullptr;
+		value = strtod(token.c_str(), &end);
+		return end != token.c_str() && *end == 0;
+	}
+}
+
+#ifdef _WIN32
+
+bool IsDirectory(const char* path)
+{
+	const DWORD attributes = GetFileAttributesA(path);
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+}
+
+bool ListDirectoryFiles(const char* directory, const char* extension, std::vector<std::string>& filenames)
+{
+	const std::string pattern = JoinPath(directory, "*");
+
+	WIN32_FIND_DATAA findData;
+	HANDLE findHandle = FindFirstFileA(pattern.c_str(), &findData);
+	if (findHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	do
+	{
+		if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0 && HasExtension(findData.cFileName, extension))
+			filenames.push_back(JoinPath(directory, findData.cFileName));
+
+	} while (FindNextFileA(findHandle, &findData));
+
+	FindClose(findHandle);
+	std::sort(begin(filenames), end(filenames));
+	return true;
+}
+
+#else
+
+bool IsDirectory(const char* path)
+{
+	struct stat info;
+	return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool ListDirectoryFiles(const char* directory, const char* extension, std::vector<std::string>& filenames)
+{
+	DIR* dir = opendir(directory);
+	if (dir == nullptr)
+		return false;
+
+	while (const dirent* entry = readdir(dir))
+	{
+		const std::string filename = JoinPath(directory, entry->d_name);
+		if (HasExtension(entry->d_name, extension) && !IsDirectory(filename.c_str()))
+			filenames.push_back(filename);
+	}
+
+	closedir(dir);
+	std::sort(begin(filenames), end(filenames));
+	return true;
+}
+
+#endif
+
+bool ReadBatchManifest(const char* filename, double defaultFrameRate, std::vector<BatchJob>& jobs)
+{
+	std::ifstream manifest(filename);
+	if (!manifest.is_open())
+		return false;
+
+	// relative recording paths are relative to the manifest
+	const std::string manifestDirectory = GetDirectory(filename);
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(manifest, line))
+	{
+		lineNumber += 1;
+
+		const std::vector<std::string> tokens = SplitManifestLine(line);
+		if (tokens.empty() || tokens[0][0] == '#')
+			continue;
+
+		BatchJob job;
+		job.frameRate = defaultFrameRate;
+
+		const std::string& path = tokens[0];
+		const bool isAbsolute = IsPathSeparator(path[0]) || (path.size() > 1 && path[1] == ':');
+		job.inputFilename = (isAbsolute) ? path : JoinPath(manifestDirectory, path);
+
+		bool isValid = true;
+		if (tokens.size() > 1)
+			isValid = ParseNumber(tokens[1], job.frameRate) && job.frameRate > 0.0;
+
+		for (size_t i = 2; isValid && i < tokens.size(); i += 2)
+		{
+			double startTime = 0.0;
+			double endTime = 0.0;
+			isValid = (i + 1 < tokens.size()) && ParseNumber(tokens[i], startTime) && ParseNumber(tokens[i + 1], endTime);
+			job.trimRanges.emplace_back(startTime, endTime);
+		}
+
+		if (!isValid)
+		{
+			printf("Wrong manifest line %d - %s\n", lineNumber, line.c_str());
+			return false;
+		}
+
+		if (job.trimRanges.empty())
+			job.trimRanges.emplace_back(0.0, 0.0);
+
+		jobs.push_back(job);
+	}
+	return true;
+}
+
+bool CollectBatchJobs(const char* source, double defaultFrameRate, const std::string& outputDirectory, std::vector<BatchJob>& jobs)
+{
+	if (IsDirectory(source))
+	{
+		std::vector<std::string> filenames;
+		if (!ListDirectoryFiles(source, ".cgi", filenames))
+			return false;
+
+		// archived recordings are trimmed without an unpack step
+		for (const char* extension : COMPRESSED_EXTENSIONS)
+			ListDirectoryFiles(source, extension, filenames);
+
+		for (const std::string& filename : filenames)
+		{
+			BatchJob job;
+			job.inputFilename = filename;
+			job.frameRate = defaultFrameRate;
+			job.trimRanges.emplace_back(0.0, 0.0);
+			jobs.push_back(job);
+		}
+	}
+	else if (!ReadBatchManifest(source, defaultFrameRate, jobs))
+	{
+		return false;
+	}
+
+	// a job never overwrites the output of a previous job
+	std::vector<std::string> outputKeys;
+	for (BatchJob& job : jobs)
+	{
+		const std::string directory = (outputDirectory.empty()) ? GetDirectory(job.inputFilename) : outputDirectory;
+		job.outputFilename = JoinPath(directory, GetBaseName(job.inputFilename) + ".fbx");
+
+		const std::string key = GetOutputKey(job.outputFilename);
+		job.isDuplicateOutput = std::find(begin(outputKeys), end(outputKeys), key) != end(outputKeys);
+		outputKeys.push_back(key);
+	}
+	return true;
+}
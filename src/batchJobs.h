@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <utility>
+
+/// <summary>
+/// One recording of a batch conversion
+/// </summary>
+struct BatchJob
+{
+	std::string		inputFilename;
+	std::string		outputFilename;		//!< fbx file, ranges get a number suffix
+	double			frameRate{ 25.0 };
+	bool			isDuplicateOutput{ false };	//!< a previous job writes the same output file, the job fails
+
+	/// pairs of start / end time in seconds, end time 0 means the whole recording
+	std::vector<std::pair<double, double>>	trimRanges;
+};
+
+/// <summary>
+/// check if a path is an existing directory
+/// </summary>
+bool IsDirectory(const char* path);
+
+/// <summary>
+/// list files of a directory (not recursive) with a given extension, the extension is compared case insensitive
+/// </summary>
+bool ListDirectoryFiles(const char* directory, const char* extension, std::vector<std::string>& filenames);
+
+/// <summary>
+/// read jobs from a manifest text file, a job per line
+///  <recording path> [frame rate] [start time] [end time] [start time] [end time] ...
+///  a path with spaces is put in quotes, empty lines and lines started with # are skipped
+/// </summary>
+bool ReadBatchManifest(const char* filename, double defaultFrameRate, std::vector<BatchJob>& jobs);
+
+/// <summary>
+/// make jobs from every *.cgi (or archived *.gz, *.zip) file of a directory or from a manifest file
+///  output files are put into the output directory or next to the recordings when it's empty,
+/// an archived recording keeps its suffix, take.cgi.gz gives take.gz.fbx
+/// </summary>
+bool CollectBatchJobs(const char* source, double defaultFrameRate, const std::string& outputDirectory, std::vector<BatchJob>& jobs);
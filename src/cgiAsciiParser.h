@@ -0,0 +1,323 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+#include <stdint.h>
+#include "cgidata.h"
+#include "parallelFor.h"
+#include "cgiLog.h"
+
+/**
+ * parse one line of an ascii cgi export into a packet.
+ *
+ * \param line zero terminated text line
+ * \param packet_number a sequential number to assign to the packet
+ * \param frame_rate is used to compute the packet time from a frame number
+ * \param data output packet
+ * \return true if all line fields are parsed
+ */
+inline bool ParseAsciiPacket(const char* line, const int packet_number, const float frame_rate, CGIDataCartesian& data)
+{
+	char start_letter = '-';
+	int  frame_number = -1;
+	int temp = 0;
+
+	memset(&data, 0, sizeof(CGIDataCartesian));
+	data.syncVal = TDDE_SYNC_VAL;
+	data.checkSum = sizeof(CGIDataCartesian);
+
+#ifdef _MSC_VER
+	int parse = sscanf_s(line,
+		"%c%d.00,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%f",
+		&start_letter, 1, &frame_number,
+		&data.x, &data.y, &data.z,
+		&data.pan, &data.tilt, &data.roll,
+		&data.zoom, &data.focus, &data.iris,
+		&temp, &data.spare.trackPos);
+#else
+	int parse = sscanf(line,
+		"%c%d.00,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%f",
+		&start_letter, &frame_number,
+		&data.x, &data.y, &data.z,
+		&data.pan, &data.tilt, &data.roll,
+		&data.zoom, &data.focus, &data.iris,
+		&temp, &data.spare.trackPos);
+#endif
+	if (parse != 13)
+		return false;
+
+	data.packetNumber = packet_number;
+
+	CGIDataCartesianVersion1* ptr = reinterpret_cast<CGIDataCartesianVersion1*>(&data);
+	ptr->frameNumber = frame_number;
+	ptr->time = static_cast<float>(frame_number / frame_rate);
+	return true;
+}
+
+/// <summary>
+/// check if recording data starts in the ASCII or binary format, a binary packet starts with the sync
+/// word low byte 0xa5, an ASCII recording has no bytes above 127 before its end or a trailing zero
+/// </summary>
+inline bool IsAsciiData(const uint8_t* buffer, const size_t size)
+{
+	// never read past the end, the buffer could be a memory mapped file without a trailing zero
+	for (size_t pos = 0; pos < size; ++pos)
+	{
+		const uint8_t c = buffer[pos];
+		if (c == 0)
+			return true;
+		if (c > 127)
+			return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// white space as sscanf skips it
+/// </summary>
+inline bool IsAsciiSpace(const char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/// <summary>
+/// parse a decimal integer at p and move p behind it, leading white spaces are skipped
+/// </summary>
+inline bool ParseAsciiInt(const char*& p, const char* end, int& value)
+{
+	while (p < end && IsAsciiSpace(*p))
+		++p;
+
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	const char* digits_begin = p;
+	int64_t result = 0;
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+	{
+		result = result * 10 + (*p - '0');
+		if (result > INT32_MAX)
+			return false;
+	}
+	if (p == digits_begin)
+		return false;
+
+	value = static_cast<int>(negative ? -result : result);
+	return true;
+}
+
+/// <summary>
+/// parse a decimal floating point number at p and move p behind it, leading white spaces are skipped
+///  the number is exact in double up to 15 significant digits and a power of ten up to 22,
+/// anything else (more digits, inf, nan, hex) is rejected, so the caller can fall back to sscanf
+/// </summary>
+inline bool ParseAsciiFloat(const char*& p, const char* end, float& value)
+{
+	static const double powers_of_ten[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	constexpr int max_power = 22;
+	constexpr int max_significant_digits = 15;
+
+	while (p < end && IsAsciiSpace(*p))
+		++p;
+
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-'))
+	{
+		negative = (*p == '-');
+		++p;
+	}
+
+	uint64_t mantissa = 0;
+	int significant_digits = 0;
+	int exponent = 0;
+	bool has_digits = false;
+
+	for (; p < end && *p >= '0' && *p <= '9'; ++p)
+	{
+		mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+		significant_digits += (mantissa != 0) ? 1 : 0;
+		has_digits = true;
+	}
+	if (p < end && *p == '.')
+	{
+		++p;
+		for (; p < end && *p >= '0' && *p <= '9'; ++p)
+		{
+			mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+			significant_digits += (mantissa != 0) ? 1 : 0;
+			exponent -= 1;
+			has_digits = true;
+		}
+	}
+	if (!has_digits || significant_digits > max_significant_digits)
+		return false;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		++p;
+		int exponent_value = 0;
+		if (p == end || IsAsciiSpace(*p) || !ParseAsciiInt(p, end, exponent_value))
+			return false;
+		exponent += exponent_value;
+	}
+	if (exponent < -max_power || exponent > max_power)
+		return false;
+
+	double result = static_cast<double>(mantissa);
+	result = (exponent < 0) ? result / powers_of_ten[-exponent] : result * powers_of_ten[exponent];
+
+	value = static_cast<float>(negative ? -result : result);
+	return true;
+}
+
+/// <summary>
+/// hand written parse of the ascii packet line [line; line_end), the same format as ParseAsciiPacket
+///  a line the fast path can't handle is parsed again with sscanf
+/// </summary>
+inline bool ParseAsciiLine(const char* line, const char* line_end, const int packet_number, const float frame_rate, CGIDataCartesian& data)
+{
+	const char* p = line;
+	int frame_number = 0;
+	int temp = 0;
+	float values[10];
+
+	bool status = (p < line_end);
+	if (status)
+	{
+		// start letter
+		++p;
+		status = ParseAsciiInt(p, line_end, frame_number)
+			&& (line_end - p >= 4) && memcmp(p, ".00,", 4) == 0;
+		p += 4;
+	}
+	for (int i = 0; i < 9 && status; ++i)
+	{
+		status = ParseAsciiFloat(p, line_end, values[i]) && p < line_end && *p == ',';
+		++p;
+	}
+	status = status && ParseAsciiInt(p, line_end, temp) && p < line_end && *p == ',';
+	++p;
+	status = status && ParseAsciiFloat(p, line_end, values[9]);
+
+	if (!status)
+	{
+		char buffer[1024];
+		const size_t length = std::min(static_cast<size_t>(line_end - line), sizeof(buffer) - 1);
+		memcpy(buffer, line, length);
+		buffer[length] = 0;
+		return ParseAsciiPacket(buffer, packet_number, frame_rate, data);
+	}
+
+	memset(&data, 0, sizeof(CGIDataCartesian));
+	data.syncVal = TDDE_SYNC_VAL;
+	data.checkSum = sizeof(CGIDataCartesian);
+
+	data.x = values[0];
+	data.y = values[1];
+	data.z = values[2];
+	data.pan = values[3];
+	data.tilt = values[4];
+	data.roll = values[5];
+	data.zoom = values[6];
+	data.focus = values[7];
+	data.iris = values[8];
+	data.spare.trackPos = values[9];
+	data.packetNumber = packet_number;
+
+	CGIDataCartesianVersion1* ptr = reinterpret_cast<CGIDataCartesianVersion1*>(&data);
+	ptr->frameNumber = frame_number;
+	ptr->time = static_cast<float>(frame_number / frame_rate);
+	return true;
+}
+
+/// <summary>
+/// parse a whole ascii cgi export, a packet per line
+///  the text is split into line aligned blocks, a first pass counts lines of every block to pre-size
+/// the output and to number packets, a second pass parses the blocks in parallel
+///  the text ends at the first zero byte, trailing white spaces and empty lines are ignored
+/// </summary>
+/// <returns>false if any line can't be parsed</returns>
+inline bool ParseAsciiPackets(const char* text, size_t size, const float frame_rate, std::vector<CGIDataCartesian>& packets)
+{
+	packets.clear();
+
+	const char* text_zero = static_cast<const char*>(memchr(text, 0, size));
+	const char* text_end = (text_zero != nullptr) ? text_zero : text + size;
+	while (text_end > text && IsAsciiSpace(text_end[-1]))
+		--text_end;
+
+	if (text_end == text)
+		return true;
+
+	constexpr size_t min_block_size = 1 << 20;
+	const size_t text_size = static_cast<size_t>(text_end - text);
+	const size_t number_of_blocks = GetNumberOfParallelBlocks(text_size, min_block_size);
+
+	// block bounds right behind a line end
+	std::vector<const char*> bounds(number_of_blocks + 1, text_end);
+	bounds[0] = text;
+	for (size_t block = 1; block < number_of_blocks; ++block)
+	{
+		const char* p = std::max(text + block * (text_size / number_of_blocks), bounds[block - 1]);
+		const char* line_end = static_cast<const char*>(memchr(p, '\n', text_end - p));
+		bounds[block] = (line_end != nullptr) ? line_end + 1 : text_end;
+	}
+
+	// every line ends with a new line, except the last one
+	std::vector<size_t> block_lines(number_of_blocks + 1, 0);
+	ParallelFor(number_of_blocks, 1, [&](const size_t first, const size_t last, const size_t)
+		{
+			for (size_t block = first; block < last; ++block)
+				block_lines[block + 1] = static_cast<size_t>(std::count(bounds[block], bounds[block + 1], '\n'));
+		});
+	block_lines[number_of_blocks] += 1;
+
+	for (size_t block = 0; block < number_of_blocks; ++block)
+		block_lines[block + 1] += block_lines[block];
+
+	packets.resize(block_lines[number_of_blocks]);
+
+	// index of the first line with a parse error in every block
+	const size_t no_error = packets.size();
+	std::vector<size_t> error_lines(number_of_blocks, no_error);
+
+	ParallelFor(number_of_blocks, 1, [&](const size_t first, const size_t last, const size_t)
+		{
+			for (size_t block = first; block < last; ++block)
+			{
+				const char* p = bounds[block];
+				const char* block_end = bounds[block + 1];
+
+				for (size_t index = block_lines[block]; p < block_end; ++index)
+				{
+					const char* line_end = static_cast<const char*>(memchr(p, '\n', block_end - p));
+					if (line_end == nullptr)
+						line_end = block_end;
+
+					if (!ParseAsciiLine(p, line_end, static_cast<int>(index), frame_rate, packets[index]))
+					{
+						error_lines[block] = index;
+						break;
+					}
+					p = line_end + 1;
+				}
+			}
+		});
+
+	const size_t error_line = *std::min_element(begin(error_lines), end(error_lines));
+	if (error_line != no_error)
+	{
+		LogPrintf("loadCGI ERROR: Parse error for line %zu\n", error_line + 1);
+		packets.clear();
+		return false;
+	}
+	return true;
+}
@@ -3,8 +3,24 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <functional>
 #include "cgidata.h"
+#include "cgiStreamReader.h"
+#include "cgiInflateStream.h"
+#include "cgiAsciiParser.h"
+#include "cgiPacketScan.h"
+#include "cgiPacketSort.h"
+#include "cgiPacketColumns.h"
+#include "cgiResample.h"
+#include "cgiFilter.h"
+#include "cgiCoordinateSystem.h"
+#include "cgiLensCalibration.h"
+#include "cgiKeyReduction.h"
 #include "fbxtypes.h"
+#include "cgiLog.h"
 
 /// <summary>
 /// A wrapper class around input bytes array to view it as array of desired structured data
@@ -16,13 +32,13 @@ public:
 	ConstArrayView()
 	{}
 
-	ConstArrayView(uint8_t* buffer, size_t size)
+	ConstArrayView(const uint8_t* buffer, size_t size)
 	{
-		m_Array = reinterpret_cast<T*>(buffer);
+		m_Array = reinterpret_cast<const T*>(buffer);
 		m_Count = size / sizeof(T);
 	}
 
-	ConstArrayView(T* buffer, size_t count)
+	ConstArrayView(const T* buffer, size_t count)
 	{
 		m_Array = buffer;
 		m_Count = count;
@@ -51,7 +67,7 @@ public:
 	bool IsEmpty() const { return m_Count == 0; }
 
 private:
-	T* m_Array{ nullptr };
+	const T* m_Array{ nullptr };
 	size_t	m_Count{ 0 };
 };
 
@@ -66,27 +82,225 @@ class CGIConvert
 {
 public:
 	
-	bool IsEmpty() const { return m_PacketsView.IsEmpty(); }
+	bool IsEmpty() const { return m_SortedPackets.empty(); }
 
 	/// <summary>
-	/// returns a total number of imported packets
+	/// returns a total number of imported packets, packets with a wrong check sum are not counted
 	/// </summary>
-	int GetNumberOfPackets() const { return static_cast<int>(m_PacketsView.Count()); }
+	int GetNumberOfPackets() const { return static_cast<int>(m_SortedPackets.size()); }
 
 	/// <summary>
 	/// returns a packet sorted by timecode value
 	/// </summary>
-	const CGIDataCartesian& GetPacket(const int index) 
+	const CGIDataCartesian& GetPacket(const int index) const
 	{ 
 		const size_t lookUpIndex = m_SortedPackets[index];
 		return m_PacketsView.At(lookUpIndex); 
 	}
 
+	/// <summary>
+	/// how much the input packets were out of the timecode order
+	/// </summary>
+	PacketOrder GetInputOrder() const { return m_InputOrder; }
+
+	/// <summary>
+	/// check sum validation of binary packets, on by default
+	///  packets with a wrong check sum are excluded from the sorted packets
+	/// </summary>
+	void SetCheckSumValidation(const bool validate) { m_ValidateCheckSum = validate; }
+
+	/// <summary>
+	/// number of input packets rejected by the check sum validation
+	/// </summary>
+	size_t GetNumberOfBadPackets() const { return m_NumberOfBadPackets; }
+
+	/// <summary>
+	/// a bit per input packet (in the input order), bit is set for a packet with a wrong check sum
+	/// </summary>
+	const std::vector<uint64_t>& GetBadPacketsMask() const { return m_BadPacketsMask; }
+
+	/// <summary>
+	/// low-pass filter of the channels noise, off by default
+	/// </summary>
+	void SetFiltering(const CGIFiltering& filtering) { m_Filtering = filtering; }
+	const CGIFiltering& GetFiltering() const { return m_Filtering; }
+
+	/// <summary>
+	/// output key frame grid of an export, by default every packet becomes a key
+	/// </summary>
+	void SetResampling(const CGIResampling& resampling) { m_Resampling = resampling; }
+	const CGIResampling& GetResampling() const { return m_Resampling; }
+
+	/// <summary>
+	/// key reduction of exported curves, off by default
+	/// </summary>
+	void SetKeyReduction(const CGIKeyReduction& reduction) { m_KeyReduction = reduction; }
+	const CGIKeyReduction& GetKeyReduction() const { return m_KeyReduction; }
+
+	/// <summary>
+	/// build a columnar copy of sorted packets, nothing to do when columns are built for the frame rate already
+	///  columns are dropped on every load
+	/// </summary>
+	void BuildColumns(const double frame_rate)
+	{
+		const size_t count = m_SortedPackets.size();
+		if (m_Columns.Count() == count && m_Columns.frameRate == frame_rate)
+			return;
+
+		m_Columns.SetFrameRate(frame_rate);
+		m_Columns.Resize(count);
+
+		ParallelFor(count, 1 << 16, [&](const size_t first, const size_t last, const size_t)
+			{
+				for (size_t i = first; i < last; ++i)
+					m_Columns.Set(i, m_PacketsView.At(m_SortedPackets[i]));
+			});
+	}
+
+	bool HasColumns() const { return !m_Columns.IsEmpty(); }
+
+	/// <summary>
+	/// true when packets are viewed in the input buffer, false when they are unpacked into own memory
+	/// </summary>
+	bool IsViewingInput() const
+	{
+		return !m_PacketsView.IsEmpty() && (m_UnpackedPackets.empty() || &m_PacketsView.First() != m_UnpackedPackets.data());
+	}
+
+	/// <summary>
+	/// columnar copy of sorted packets, see BuildColumns
+	/// </summary>
+	const CGIPacketColumns& GetColumns() const { return m_Columns; }
+
+	/// <summary>
+	/// indices of valid input packets sorted by timecode
+	/// </summary>
+	const std::vector<size_t>& GetSortedPacketIndices() const { return m_SortedPackets; }
+
+	/// <summary>
+	/// number of viewed input packets, including packets with a wrong check sum
+	/// </summary>
+	size_t GetNumberOfInputPackets() const { return m_PacketsView.Count(); }
+
+	/// <summary>
+	/// view binary packets in place with an already known sorted order of valid packets (see CGIRecordingIndex)
+	///  the check sum validation and the sorting are skipped, packets are read only when a pass needs them
+	/// </summary>
+	bool LoadSortedPackets(const uint8_t* buffer, size_t size, const std::vector<uint32_t>& sorted_packets, const PacketOrder input_order)
+	{
+		m_UnpackedPackets.clear();
+		m_PacketsView = ConstArrayView<CGIDataCartesian>(buffer, size);
+		m_InputOrder = input_order;
+
+		const size_t count = m_PacketsView.Count();
+		if (size % sizeof(CGIDataCartesian) != 0 || sorted_packets.size() > count)
+		{
+			m_PacketsView = ConstArrayView<CGIDataCartesian>();
+			CalculateSortedPacketIndices();
+			return false;
+		}
+
+		m_Columns.Clear();
+		m_SortedPackets.assign(begin(sorted_packets), end(sorted_packets));
+
+		// packets which are not in the sorted list are the ones with a wrong check sum
+		m_NumberOfBadPackets = count - m_SortedPackets.size();
+		m_BadPacketsMask.clear();
+		if (m_NumberOfBadPackets > 0)
+		{
+			m_BadPacketsMask.assign((count + 63) / 64, ~uint64_t(0));
+			for (const size_t index : m_SortedPackets)
+				m_BadPacketsMask[index >> 6] &= ~(uint64_t(1) << (index & 63));
+			if (count % 64 != 0)
+				m_BadPacketsMask.back() &= (uint64_t(1) << (count % 64)) - 1;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// binary search of the sorted packets range [first; last) with a timecode label within [start_time; end_time] seconds
+	///  the same result as CGIPacketColumns::FindTimeRange, but without columns, only O(log n) packets are read
+	/// </summary>
+	void FindTimeRange(const double frame_rate, const double start_time, const double end_time, size_t& first, size_t& last) const
+	{
+		first = 0;
+		last = 0;
+		if (m_SortedPackets.empty())
+			return;
+
+		const CGIFrameRate rate = CGIFrameRate::FromDouble(frame_rate);
+		auto fn_getFrameIndex = [this, &rate](const size_t index) -> int64_t
+			{
+				return TimeCodeToFrameCount(m_PacketsView.At(m_SortedPackets[index]).timeCode, rate);
+			};
+
+		const bool drop_frame = m_PacketsView.At(m_SortedPackets.front()).timeCode.dropFrame != 0;
+		const int64_t start_frame = LabelSecondsToFrameCount(start_time, rate, drop_frame, false);
+		const int64_t end_frame = LabelSecondsToFrameCount(end_time, rate, drop_frame, true);
+
+		// first frame index >= start
+		size_t low = 0;
+		size_t high = m_SortedPackets.size();
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (fn_getFrameIndex(middle) < start_frame)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		first = low;
+
+		// first frame index > end
+		high = m_SortedPackets.size();
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (fn_getFrameIndex(middle) <= end_frame)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		last = low;
+	}
+
+	/// <summary>
+	/// keep only the sorted packets range [first; last), so next passes (columns, export) read only these packets
+	/// </summary>
+	void KeepSortedPackets(const size_t first, const size_t last)
+	{
+		const size_t count = m_SortedPackets.size();
+		const size_t range_last = std::min(last, count);
+		const size_t range_first = std::min(first, range_last);
+
+		m_SortedPackets.erase(begin(m_SortedPackets) + range_last, end(m_SortedPackets));
+		m_SortedPackets.erase(begin(m_SortedPackets), begin(m_SortedPackets) + range_first);
+		m_Columns.Clear();
+	}
+
+	typedef std::function<bool(const CGIDataCartesian&)>	PacketFilter;
+
 	/// <summary>
 	/// main entry method, process the input buffer
+	///  binary data is viewed in place (zero-copy), so the buffer could be a memory mapped file
+	///  gzip or zip compressed data is inflated by small chunks right into packets,
+	/// only packets accepted by the filter are inflated into memory (all packets when filter is empty)
 	/// </summary>
-	bool LoadPackets(uint8_t* buffer, size_t size, const float frame_rate)
+	bool LoadPackets(const uint8_t* buffer, size_t size, const float frame_rate, const PacketFilter& filter = nullptr)
 	{
+		if (CGIInflateStream::IsCompressed(buffer, size))
+		{
+			// the whole buffer is one compressed chunk, the inflated data is still parsed by chunks
+			const uint8_t* next_chunk = buffer;
+			return LoadPacketsByChunks(frame_rate, filter, [&](const uint8_t*& data) -> size_t
+				{
+					data = next_chunk;
+					const size_t data_size = (next_chunk != nullptr) ? size : 0;
+					next_chunk = nullptr;
+					return data_size;
+				});
+		}
+
 		if (IsAscii(buffer, size))
 		{
 			return LoadAscii(buffer, size, frame_rate);// , m_Packets);
@@ -95,6 +309,27 @@ public:
 		return LoadBinary(buffer, size); // , m_Packets);
 	}
 
+	/// <summary>
+	/// streaming entry method, reads the input stream by chunks of a given size
+	///  only packets accepted by the filter are kept (all packets when filter is empty),
+	/// so the memory usage is bounded by a chunk size and the kept packets, not by the stream size
+	///  a gzip or zip compressed stream is inflated on the fly
+	/// </summary>
+	bool LoadPacketsFromStream(std::istream& stream, const float frame_rate, const size_t chunk_size, const PacketFilter& filter = nullptr)
+	{
+		std::vector<uint8_t> chunk(std::max(chunk_size, sizeof(CGIDataCartesian)));
+
+		return LoadPacketsByChunks(frame_rate, filter, [&](const uint8_t*& data) -> size_t
+			{
+				if (!stream)
+					return 0;
+
+				stream.read(reinterpret_cast<char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+				data = chunk.data();
+				return static_cast<size_t>(stream.gcount());
+			});
+	}
+
 	void SetFOV(float w, float h)
 	{
 		m_fovAnimation = true;
@@ -104,18 +339,22 @@ public:
 
 	bool IsCalibratedCGI() const
 	{
-		if (m_PacketsView.IsEmpty())
+		if (IsEmpty())
 		{
-			printf("calibratedCGI: not CGI data loaded.\n");
+			LogPrintf("calibratedCGI: not CGI data loaded.\n");
 			return false;
 		}
-		if (m_PacketsView.First().zoom < 0) return true;
+		if (GetPacket(0).zoom < 0) return true;
 		return false;
 	}
 
 	float ConvertFocalLength(const CGIDataCartesian& cgiData) const
 	{
-		return -1.0f * cgiData.zoom; // focal length in mm is fine ....
+		return ConvertFocalLength(cgiData.zoom);
+	}
+	float ConvertFocalLength(const float zoom) const
+	{
+		return -1.0f * zoom; // focal length in mm is fine ....
 	}
 	void ConvertFocalLengthInv(float focalLength, CGIDataCartesian& cgiData) const
 	{
@@ -132,14 +371,103 @@ public:
 	}
 
 	float ConvertFocusDistance(const CGIDataCartesian& cgiData) const
+	{
+		return ConvertFocusDistance(cgiData.focus);
+	}
+	float ConvertFocusDistance(const float focus) const
 	{
 		constexpr const float FOCUS_DISTANCE_INFINITY = 1000000.f; // infifity is 1km away...  
 
-		if (fabs(cgiData.focus) < 0.0001f) return FOCUS_DISTANCE_INFINITY;
-		return -1.0f * m_metricScalingFactorTD2FBX / cgiData.focus; // 
+		if (fabs(focus) < 0.0001f) return FOCUS_DISTANCE_INFINITY;
+		return -1.0f * m_metricScalingFactorTD2FBX / focus; // 
 
 	}
 
+	/// <summary>
+	/// lens calibration table of an uncalibrated rig, its chip size turns on the field of view animation
+	/// </summary>
+	void SetLensCalibration(const CGILensCalibration& calibration)
+	{
+		m_LensCalibration = calibration;
+		m_fovAnimation = false;
+		if (calibration.HasChipSize())
+			SetFOV(calibration.chipWidth, calibration.chipHeight);
+	}
+	const CGILensCalibration& GetLensCalibration() const { return m_LensCalibration; }
+
+	/// <summary>
+	/// a calibrated rig or a calibration table gives the focal length and the focus distance
+	/// </summary>
+	bool HasFocalLength() const { return IsCalibratedCGI() || !m_LensCalibration.zoom.empty(); }
+	bool HasFocusDistance() const { return IsCalibratedCGI() || !m_LensCalibration.focus.empty(); }
+	bool HasTStop() const { return !IsCalibratedCGI() && !m_LensCalibration.iris.empty(); }
+
+	/// <summary>
+	/// FieldOfView curve values of packets [first; first + count) in columns, the vertical field of view in degrees
+	/// when the chip size is set, otherwise the focal length in mm
+	///  per packet values are interpolated in a lookup table of the lens function, see CGILensLUT
+	/// </summary>
+	void ConvertFieldOfView(const CGIPacketColumns& columns, const size_t first, const size_t count, float* output) const
+	{
+		const float* zoom = columns.zoom.data() + first;
+		const double chipHeight = m_chipHeight;
+
+		std::function<double(double)> fn_lens = [](const double focalLength) { return focalLength; };
+		if (m_fovAnimation)
+			fn_lens = [chipHeight](const double focalLength) { return 2.0 * 180.0 * atan(0.5 * chipHeight / focalLength) / pi; };
+
+		CGILensLUT lut;
+		if (IsCalibratedCGI())
+		{
+			if (!m_fovAnimation)
+			{
+				for (size_t i = 0; i < count; ++i)
+					output[i] = -1.0f * zoom[i];
+				return;
+			}
+
+			// the rig sends the focal length, the table covers the range of the packets
+			const auto range = std::minmax_element(zoom, zoom + count);
+			lut.Build((count > 0) ? *range.first : 0.0f, (count > 0) ? *range.second : 0.0f,
+				[this, &fn_lens](const double value) { return fn_lens(static_cast<double>(ConvertFocalLength(static_cast<float>(value)))); });
+		}
+		else
+		{
+			lut.Build(m_LensCalibration.zoom, fn_lens);
+		}
+		lut.Evaluate(zoom, count, output);
+	}
+
+	/// <summary>
+	/// FocusDistance curve values of packets [first; first + count) in columns, in the units of the coordinate system
+	/// </summary>
+	void ConvertFocusDistance(const CGIPacketColumns& columns, const size_t first, const size_t count, float* output) const
+	{
+		const float* focus = columns.focus.data() + first;
+
+		if (IsCalibratedCGI())
+		{
+			for (size_t i = 0; i < count; ++i)
+				output[i] = ConvertFocusDistance(focus[i]);
+			return;
+		}
+
+		const double unitScale = m_metricScalingFactorTD2FBX;
+		CGILensLUT lut;
+		lut.Build(m_LensCalibration.focus, [unitScale](const double distance) { return unitScale * distance; });
+		lut.Evaluate(focus, count, output);
+	}
+
+	/// <summary>
+	/// T-stop values of packets [first; first + count) in columns, an uncalibrated rig with an iris calibration table
+	/// </summary>
+	void ConvertTStop(const CGIPacketColumns& columns, const size_t first, const size_t count, float* output) const
+	{
+		CGILensLUT lut;
+		lut.Build(m_LensCalibration.iris, [](const double tstop) { return tstop; });
+		lut.Evaluate(columns.iris.data() + first, count, output);
+	}
+
 	// --------------------------------------------------------------------------------------
 	// FBX-Data in MAYA system: TX(X*100),TY(Z*100),TZ(-Y*100),
 	//                          RX(roll),RY(-pan),RZ(tilt): start position (0,0,0): optical axis along -z-axis
@@ -150,38 +478,40 @@ public:
 	//                          Coordinate units are in m.
 	//          
 	// MAYA_X=-TD_Y, MAYA_Y=TD_Z, MAYA_Z=-TD_X
-	void ConvertToFBX(const CGIDataCartesian& data,
-		fbx::FVector4& pos,
-		fbx::FVector4& rot) const
+	//  other targets are presets of cgiCoordinateSystem.h
+
+	/// <summary>
+	/// convert packets [first; first + count) in columns into the coordinate system, fbx channels are written into destination arrays
+	///  the kernel of the preset is a branch-free loop per channel the compiler vectorizes
+	/// </summary>
+	/// <param name="pos">destination arrays of x, y, z translation</param>
+	/// <param name="rot">destination arrays of x, y, z rotation</param>
+	void ConvertToFBX(const CGIPacketColumns& columns, const size_t first, const size_t count,
+		float* const pos[3],
+		float* const rot[3]) const
 	{
+		ConvertColumnsToCoordinateSystem(m_CoordinateSystem, columns, first, count, pos, rot);
+	}
 
-		if (m_trafoToMayaCoordinateSystem)
-		{
-			const float meterToCm = m_metricScalingFactorTD2FBX;
-			pos = { -1.0f * data.y * meterToCm, data.z * meterToCm, -1.0f * data.x * meterToCm };
-			
-			fbx::FVector4 zxyRot = { data.tilt, -1.0f * data.pan, -1.0f * data.roll };
-			rot = zxyRot;
-
-			// in td: rot um y global (-pan), dann um x dynamic, dann roll  
-			// in fbx: rot um x global (tilt), dann um y global (-pan), dann roll
-		}
-		else
-		{
-			pos = { data.x, data.y, data.z };
-			rot = { data.roll, -1.0f * data.tilt, -1.0f * data.pan };
-		}
+	/// <summary>
+	/// coordinate system of the exported camera, Maya by default
+	/// </summary>
+	void SetCoordinateSystem(const CGICoordinateSystem coordinateSystem)
+	{
+		m_CoordinateSystem = coordinateSystem;
+		m_metricScalingFactorTD2FBX = GetCoordinateSystemUnitScale(coordinateSystem);
 	}
+	CGICoordinateSystem GetCoordinateSystem() const { return m_CoordinateSystem; }
 
 private:
 
 	// 
-	bool                          m_fovAnimation{ true };
+	bool                          m_fovAnimation{ false };
 	double                        m_chipWidth{ 640.0 };
 	double                        m_chipHeight{ 480.0 };
 
-	/// transform between TD-Coordinate system and MAYA/MB
-	bool                          m_trafoToMayaCoordinateSystem{ true };
+	/// transform between TD-Coordinate system and the export target, MAYA/MB by default
+	CGICoordinateSystem           m_CoordinateSystem{ CGICoordinateSystem::Maya };
 
 	/// transform from technofolly meters to animation metric system (default: cm, hence 100.0 is used)
 	float                         m_metricScalingFactorTD2FBX{ 100.0f };
@@ -190,25 +520,116 @@ private:
 
 	/// indices of packets data sorted by timestamp
 	std::vector<size_t> m_SortedPackets;
+	PacketOrder         m_InputOrder{ PacketOrder::Sorted };
 
 	/// store in memory in case we unpack packets from ascii
 	std::vector<CGIDataCartesian> m_UnpackedPackets;
 
+	/// check sum validation results of viewed binary packets
+	bool                          m_ValidateCheckSum{ true };
+
+	CGILensCalibration            m_LensCalibration;
+	CGIFiltering                  m_Filtering;
+	CGIResampling                 m_Resampling;
+	CGIKeyReduction               m_KeyReduction;
+	std::vector<uint64_t>         m_BadPacketsMask;
+	size_t                        m_NumberOfBadPackets{ 0 };
+
+	/// optional columnar copy of sorted packets
+	CGIPacketColumns              m_Columns;
+
+	/// <summary>
+	/// decode packets of a raw or compressed stream, fn_next_chunk returns a size of the next chunk or 0 at the end
+	/// </summary>
+	template<typename F>
+	bool LoadPacketsByChunks(const float frame_rate, const PacketFilter& filter, F&& fn_next_chunk)
+	{
+		m_UnpackedPackets.clear();
+		m_PacketsView = ConstArrayView<CGIDataCartesian>();
+		m_SortedPackets.clear();
+		m_Columns.Clear();
+		m_BadPacketsMask.clear();
+		m_NumberOfBadPackets = 0;
+
+		CGIStreamReader reader(frame_rate, [&](const CGIDataCartesian& packet)
+			{
+				if (!filter || filter(packet))
+					m_UnpackedPackets.push_back(packet);
+			});
+
+		CGIInflateStream inflater([&reader](const uint8_t* data, size_t size) -> bool
+			{
+				return reader.Feed(data, size);
+			});
+
+		bool is_first_chunk = true;
+		bool is_compressed = false;
+		const uint8_t* data = nullptr;
+
+		for (size_t size = fn_next_chunk(data); size > 0; size = fn_next_chunk(data))
+		{
+			if (is_first_chunk)
+			{
+				is_compressed = CGIInflateStream::IsCompressed(data, size);
+				is_first_chunk = false;
+			}
+
+			const bool status = (is_compressed) ? inflater.Feed(data, size) : reader.Feed(data, size);
+			if (!status)
+				return false;
+		}
+
+		if (is_compressed && !inflater.Finish())
+			return false;
+		if (!reader.Finish())
+			return false;
+
+		m_PacketsView = ConstArrayView<CGIDataCartesian>(m_UnpackedPackets.data(), m_UnpackedPackets.size());
+		CalculateSortedPacketIndices();
+		return true;
+	}
+
 	void CalculateSortedPacketIndices()
 	{
+		m_SortedPackets.clear();
+		m_Columns.Clear();
 		if (m_PacketsView.IsEmpty())
 			return;
 
-		m_SortedPackets.resize(m_PacketsView.Count());
-		for (size_t i = 0; i < m_PacketsView.Count(); ++i)
-			m_SortedPackets[i] = i;
-
-		std::sort(begin(m_SortedPackets), end(m_SortedPackets), [&](const size_t a, const size_t b)
+		m_SortedPackets.resize(m_PacketsView.Count() - m_NumberOfBadPackets);
+		if (m_NumberOfBadPackets == 0)
+		{
+			for (size_t i = 0; i < m_PacketsView.Count(); ++i)
+				m_SortedPackets[i] = i;
+		}
+		else
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < m_PacketsView.Count(); ++i)
 			{
-				const CGIDataCartesian& packetA = m_PacketsView.At(a);
-				const CGIDataCartesian& packetB = m_PacketsView.At(b);
-				return packetA.timeCode < packetB.timeCode;
-			});
+				if (!IsPacketMasked(m_BadPacketsMask, i))
+					m_SortedPackets[count++] = i;
+			}
+		}
+
+		m_InputOrder = SortPacketIndices(&m_PacketsView.First(), m_SortedPackets);
+
+		if (m_InputOrder == PacketOrder::Shuffled)
+		{
+			// random order lookups would touch a new cache line for every packet, make a sorted copy instead
+			std::vector<CGIDataCartesian> sortedPackets(m_SortedPackets.size());
+			ParallelFor(m_SortedPackets.size(), 1 << 16, [&](const size_t first, const size_t last, const size_t)
+				{
+					for (size_t i = first; i < last; ++i)
+						sortedPackets[i] = m_PacketsView.At(m_SortedPackets[i]);
+				});
+
+			m_UnpackedPackets.swap(sortedPackets);
+			m_PacketsView = ConstArrayView<CGIDataCartesian>(m_UnpackedPackets.data(), m_UnpackedPackets.size());
+
+			for (size_t i = 0; i < m_SortedPackets.size(); ++i)
+				m_SortedPackets[i] = i;
+		}
 	}
 
 	/**
@@ -218,27 +639,11 @@ private:
 	 * \param size
 	 * \return true if file is in ASCII
 	 */
-	bool IsAscii(uint8_t* buffer, size_t size)
+	bool IsAscii(const uint8_t* buffer, size_t size)
 	{
-		uint8_t* readPtr = buffer;
-		size_t pos = 0;
-
-		int c;
-		while ((c = *readPtr) != EOF && c <= 127 && pos < size)
-		{
-			++pos;
-			++readPtr;
-		}
-
-		return (c == EOF || c == 0);
+		return IsAsciiData(buffer, size);
 	}
 
-	struct membuf : std::streambuf {
-		membuf(char* begin, char* end) {
-			this->setg(begin, begin, end);
-		}
-	};
-
 	/**
 	 * extract CGIData packets from a data buffer and put them into given packets array.
 	 *
@@ -248,78 +653,17 @@ private:
 	 * \param packets
 	 * \return true if operation was successfull
 	 */
-	bool LoadAscii(uint8_t* buffer, size_t size, float frame_rate)
+	bool LoadAscii(const uint8_t* buffer, size_t size, float frame_rate)
 	{
-		char line[1024]{ 0 };
-		char start_letter = '-';
-		int  frame_number = -1;
-
-		int packet_number = 0;
-		int temp = 0;
-
-		membuf mem_buf(reinterpret_cast<char*>(buffer), reinterpret_cast<char*>(buffer + size));
-		std::istream in(&mem_buf);
-
-		m_UnpackedPackets.clear();
-
-		do {
-			in.getline(line, 1024, '\n');
-			if (in.eof()) break;
-
-			CGIDataCartesian data;
-			memset(&data, 0, sizeof(CGIDataCartesian));
-			data.syncVal = TDDE_SYNC_VAL;
-			data.checkSum = sizeof(CGIDataCartesian);
-
-#ifdef _MSC_VER
-			int parse = sscanf_s(line,
-				"%c%d.00,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%f",
-				&start_letter, 1, &frame_number,
-				&data.x, &data.y, &data.z,
-				&data.pan, &data.tilt, &data.roll,
-				&data.zoom, &data.focus, &data.iris,
-				&temp, &data.spare.trackPos);
-#else
-			int parse = sscanf(line,
-				"%c%d.00,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%f",
-				&start_letter, &frame_number,
-				&data.x, &data.y, &data.z,
-				&data.pan, &data.tilt, &data.roll,
-				&data.zoom, &data.focus, &data.iris,
-				&temp, &data.spare.trackPos);
-#endif
-			/*
-			if (m_verbose>1){
-				char buffer[1024];
-				sprintf(buffer,
-						"%c%d.00,%.4f,%.4f,%.4f,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
-						startLetter,frameNumber,
-						data.x,   data.y, data.z,
-						data.pan, data.tilt, data.roll,
-						data.zoom, data.focus, data.iris);
-				log() << buffer;
-			}
-			*/
-			if (parse != 13) {
-				printf("loadCGI ERROR: Parse error for line ...\n");
-				return false;
-			}
-
-			data.packetNumber = packet_number;
-			packet_number += 1;
-
-			CGIDataCartesianVersion1* ptr = reinterpret_cast<CGIDataCartesianVersion1*>(&data);
-			ptr->frameNumber = frame_number;
-			ptr->time = static_cast<float>(frame_number / frame_rate);
-
-			m_UnpackedPackets.emplace_back(data);
+		m_BadPacketsMask.clear();
+		m_NumberOfBadPackets = 0;
 
-		} while (!in.eof());
+		const bool status = ParseAsciiPackets(reinterpret_cast<const char*>(buffer), size, frame_rate, m_UnpackedPackets);
 
 		m_PacketsView = ConstArrayView<CGIDataCartesian>(m_UnpackedPackets.data(), m_UnpackedPackets.size());
 		CalculateSortedPacketIndices();
 
-		return true;
+		return status;
 	}
 
 	/**
@@ -330,23 +674,49 @@ private:
 	 * \param packets
 	 * \return true if opeartion was successfull
 	 */
-	bool LoadBinary(uint8_t* buffer, size_t size)
+	bool LoadBinary(const uint8_t* buffer, size_t size)
 	{
 		if (size <= 0)
 		{
-			printf("File size is empty\n");
+			LogPrintf("File size is empty\n");
 			return false;
 		}
 
-		const size_t number_of_packets = size / sizeof(CGIDataCartesian);
+		m_BadPacketsMask.clear();
+		m_NumberOfBadPackets = 0;
 
-		if (number_of_packets == 0 || size % sizeof(CGIDataCartesian) != 0)
+		if (HasAlignedSyncWords(buffer, size))
 		{
-			printf("Wrong file content\n");
+			// zero-copy view over a well formed stream, packets of a previous load are released
+			std::vector<CGIDataCartesian> empty_packets;
+			m_UnpackedPackets.swap(empty_packets);
+			m_PacketsView = ConstArrayView<CGIDataCartesian>(buffer, size);
+
+			if (m_ValidateCheckSum)
+			{
+				m_NumberOfBadPackets = ValidatePacketCheckSums(&m_PacketsView.First(), m_PacketsView.Count(), m_BadPacketsMask);
+				if (m_NumberOfBadPackets > 0)
+					LogPrintf("Damaged stream, %zu packets with a wrong check sum are skipped\n", m_NumberOfBadPackets);
+			}
+
+			CalculateSortedPacketIndices();
+			return true;
+		}
+
+		// stream has lost or extra bytes, re-synchronize packets by the sync word and check sum
+		m_UnpackedPackets.clear();
+		m_UnpackedPackets.reserve(size / sizeof(CGIDataCartesian));
+		const size_t skipped_bytes = ScanPackets(buffer, size, m_UnpackedPackets);
+
+		if (m_UnpackedPackets.empty())
+		{
+			LogPrintf("Wrong file content\n");
 			return false;
 		}
 
-		m_PacketsView = ConstArrayView<CGIDataCartesian>(buffer, size);
+		LogPrintf("Damaged stream, recovered %zu packets, skipped %zu bytes\n", m_UnpackedPackets.size(), skipped_bytes);
+
+		m_PacketsView = ConstArrayView<CGIDataCartesian>(m_UnpackedPackets.data(), m_UnpackedPackets.size());
 		CalculateSortedPacketIndices();
 
 		return true;
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+#include "cgiPacketColumns.h"
+
+// --------------------------------------------------------------------------------------
+// Coordinate system presets of export targets
+//
+//  TD system: TX(X),TY(Y),TZ(Z), X forward, Y left, Z up, right-handed, units are in m
+//             pan - positive turns right, tilt - positive turns up, roll - positive turns the right side down
+//
+//  A preset is a policy type, every fbx channel is a source column with a constexpr sign,
+// translation channels get the preset unit scale as well. The conversion kernel is instantiated
+// per preset, so every target has a branch-free loop per channel
+//
+//  The fbx GlobalSettings declare the preset axes and units, so an importer reads the values
+// in the system they are written in and doesn't convert them once more
+
+/// <summary>
+/// export targets, the order is the value of the CLI and web UI selection
+/// </summary>
+enum class CGICoordinateSystem : uint8_t
+{
+	TD,			//!< raw crane values, Z up, right-handed, m
+	Maya,		//!< Y up, right-handed, cm, rotation order ZXY
+	Houdini,	//!< Y up, right-handed, m
+	Unreal,		//!< Z up, left-handed, cm, X forward
+	Unity,		//!< Y up, left-handed, m, Z forward
+	Count
+};
+
+/// <summary>
+/// fbx GlobalSettings axis system, an axis is 0 - X, 1 - Y, 2 - Z,
+///  a left-handed system has the coord axis sign -1
+/// </summary>
+struct CGIAxisSystem
+{
+	int		upAxis;
+	int		upAxisSign;
+	int		frontAxis;
+	int		frontAxisSign;
+	int		coordAxis;
+	int		coordAxisSign;
+};
+
+/// <summary>
+/// an fbx channel of a preset, a source column with a sign
+/// </summary>
+template<std::vector<float> CGIPacketColumns::* COLUMN, int SIGN>
+struct CGIAxis
+{
+	static const float* Source(const CGIPacketColumns& columns) { return (columns.*COLUMN).data(); }
+	static constexpr float sign = static_cast<float>(SIGN);
+};
+
+struct CGIPresetTD
+{
+	static constexpr float unitScale = 1.0f;
+	static CGIAxisSystem Axes() { return { 2, 1, 1, -1, 0, 1 }; }
+	typedef CGIAxis<&CGIPacketColumns::x, 1>		PosX;
+	typedef CGIAxis<&CGIPacketColumns::y, 1>		PosY;
+	typedef CGIAxis<&CGIPacketColumns::z, 1>		PosZ;
+	typedef CGIAxis<&CGIPacketColumns::roll, 1>		RotX;
+	typedef CGIAxis<&CGIPacketColumns::tilt, -1>	RotY;
+	typedef CGIAxis<&CGIPacketColumns::pan, -1>		RotZ;
+};
+
+// MAYA_X=-TD_Y, MAYA_Y=TD_Z, MAYA_Z=-TD_X, RX(tilt),RY(-pan),RZ(-roll), optical axis along -z-axis
+struct CGIPresetMaya
+{
+	static constexpr float unitScale = 100.0f;
+	static CGIAxisSystem Axes() { return { 1, 1, 2, 1, 0, 1 }; }
+	typedef CGIAxis<&CGIPacketColumns::y, -1>		PosX;
+	typedef CGIAxis<&CGIPacketColumns::z, 1>		PosY;
+	typedef CGIAxis<&CGIPacketColumns::x, -1>		PosZ;
+	typedef CGIAxis<&CGIPacketColumns::tilt, 1>		RotX;
+	typedef CGIAxis<&CGIPacketColumns::pan, -1>		RotY;
+	typedef CGIAxis<&CGIPacketColumns::roll, -1>	RotZ;
+};
+
+// the same axes as Maya, in meters
+struct CGIPresetHoudini
+{
+	static constexpr float unitScale = 1.0f;
+	static CGIAxisSystem Axes() { return CGIPresetMaya::Axes(); }
+	typedef CGIPresetMaya::PosX		PosX;
+	typedef CGIPresetMaya::PosY		PosY;
+	typedef CGIPresetMaya::PosZ		PosZ;
+	typedef CGIPresetMaya::RotX		RotX;
+	typedef CGIPresetMaya::RotY		RotY;
+	typedef CGIPresetMaya::RotZ		RotZ;
+};
+
+// UE_X=TD_X, UE_Y=-TD_Y, UE_Z=TD_Z, RX(roll),RY(tilt),RZ(pan) as the rotator roll, pitch and yaw
+struct CGIPresetUnreal
+{
+	static constexpr float unitScale = 100.0f;
+	static CGIAxisSystem Axes() { return { 2, 1, 1, -1, 0, -1 }; }
+	typedef CGIAxis<&CGIPacketColumns::x, 1>		PosX;
+	typedef CGIAxis<&CGIPacketColumns::y, -1>		PosY;
+	typedef CGIAxis<&CGIPacketColumns::z, 1>		PosZ;
+	typedef CGIAxis<&CGIPacketColumns::roll, 1>		RotX;
+	typedef CGIAxis<&CGIPacketColumns::tilt, 1>		RotY;
+	typedef CGIAxis<&CGIPacketColumns::pan, 1>		RotZ;
+};
+
+// UNITY_X=-TD_Y, UNITY_Y=TD_Z, UNITY_Z=TD_X, RX(-tilt),RY(pan),RZ(-roll)
+struct CGIPresetUnity
+{
+	static constexpr float unitScale = 1.0f;
+	static CGIAxisSystem Axes() { return { 1, 1, 2, 1, 0, -1 }; }
+	typedef CGIAxis<&CGIPacketColumns::y, -1>		PosX;
+	typedef CGIAxis<&CGIPacketColumns::z, 1>		PosY;
+	typedef CGIAxis<&CGIPacketColumns::x, 1>		PosZ;
+	typedef CGIAxis<&CGIPacketColumns::tilt, -1>	RotX;
+	typedef CGIAxis<&CGIPacketColumns::pan, 1>		RotY;
+	typedef CGIAxis<&CGIPacketColumns::roll, -1>	RotZ;
+};
+
+/// <summary>
+/// output[i] = SCALE * column[first + i], the scale is a compile time constant
+/// </summary>
+template<typename AXIS, typename SCALE>
+inline void ConvertAxis(const CGIPacketColumns& columns, const size_t first, const size_t count, float* output)
+{
+	const float* source = AXIS::Source(columns) + first;
+	const float scale = AXIS::sign * SCALE::value;
+
+	for (size_t i = 0; i < count; ++i)
+		output[i] = scale * source[i];
+}
+
+template<typename PRESET>
+struct CGIUnitScale { static constexpr float value = PRESET::unitScale; };
+
+struct CGINoScale { static constexpr float value = 1.0f; };
+
+/// <summary>
+/// convert packets [first; first + count) in columns into fbx channels of a preset
+/// </summary>
+/// <param name="pos">destination arrays of x, y, z translation</param>
+/// <param name="rot">destination arrays of x, y, z rotation</param>
+template<typename PRESET>
+inline void ConvertColumnsToPreset(const CGIPacketColumns& columns, const size_t first, const size_t count, float* const pos[3], float* const rot[3])
+{
+	ConvertAxis<typename PRESET::PosX, CGIUnitScale<PRESET>>(columns, first, count, pos[0]);
+	ConvertAxis<typename PRESET::PosY, CGIUnitScale<PRESET>>(columns, first, count, pos[1]);
+	ConvertAxis<typename PRESET::PosZ, CGIUnitScale<PRESET>>(columns, first, count, pos[2]);
+	ConvertAxis<typename PRESET::RotX, CGINoScale>(columns, first, count, rot[0]);
+	ConvertAxis<typename PRESET::RotY, CGINoScale>(columns, first, count, rot[1]);
+	ConvertAxis<typename PRESET::RotZ, CGINoScale>(columns, first, count, rot[2]);
+}
+
+/// <summary>
+/// the kernel instance of a run time selected preset
+/// </summary>
+inline void ConvertColumnsToCoordinateSystem(const CGICoordinateSystem coordinateSystem, const CGIPacketColumns& columns, const size_t first, const size_t count,
+	float* const pos[3], float* const rot[3])
+{
+	switch (coordinateSystem)
+	{
+	case CGICoordinateSystem::TD: ConvertColumnsToPreset<CGIPresetTD>(columns, first, count, pos, rot); break;
+	case CGICoordinateSystem::Houdini: ConvertColumnsToPreset<CGIPresetHoudini>(columns, first, count, pos, rot); break;
+	case CGICoordinateSystem::Unreal: ConvertColumnsToPreset<CGIPresetUnreal>(columns, first, count, pos, rot); break;
+	case CGICoordinateSystem::Unity: ConvertColumnsToPreset<CGIPresetUnity>(columns, first, count, pos, rot); break;
+	default: ConvertColumnsToPreset<CGIPresetMaya>(columns, first, count, pos, rot); break;
+	}
+}
+
+/// <summary>
+/// scale of meters into the units of a preset
+/// </summary>
+inline float GetCoordinateSystemUnitScale(const CGICoordinateSystem coordinateSystem)
+{
+	switch (coordinateSystem)
+	{
+	case CGICoordinateSystem::TD: return CGIPresetTD::unitScale;
+	case CGICoordinateSystem::Houdini: return CGIPresetHoudini::unitScale;
+	case CGICoordinateSystem::Unreal: return CGIPresetUnreal::unitScale;
+	case CGICoordinateSystem::Unity: return CGIPresetUnity::unitScale;
+	default: return CGIPresetMaya::unitScale;
+	}
+}
+
+/// <summary>
+/// fbx axis system of a preset
+/// </summary>
+inline CGIAxisSystem GetCoordinateSystemAxes(const CGICoordinateSystem coordinateSystem)
+{
+	switch (coordinateSystem)
+	{
+	case CGICoordinateSystem::TD: return CGIPresetTD::Axes();
+	case CGICoordinateSystem::Houdini: return CGIPresetHoudini::Axes();
+	case CGICoordinateSystem::Unreal: return CGIPresetUnreal::Axes();
+	case CGICoordinateSystem::Unity: return CGIPresetUnity::Axes();
+	default: return CGIPresetMaya::Axes();
+	}
+}
+
+/// <summary>
+/// fbx UnitScaleFactor of a preset, the size of a scene unit in cm
+/// </summary>
+inline double GetCoordinateSystemUnitScaleFactor(const CGICoordinateSystem coordinateSystem)
+{
+	return 100.0 / static_cast<double>(GetCoordinateSystemUnitScale(coordinateSystem));
+}
+
+/// <summary>
+/// preset from a name - td, maya, houdini, unreal or unity
+/// </summary>
+inline bool ParseCoordinateSystem(const char* name, CGICoordinateSystem& coordinateSystem)
+{
+	const char* names[] = { "td", "maya", "houdini", "unreal", "unity" };
+	for (size_t i = 0; i < static_cast<size_t>(CGICoordinateSystem::Count); ++i)
+	{
+		if (strcmp(name, names[i]) == 0)
+		{
+			coordinateSystem = static_cast<CGICoordinateSystem>(i);
+			return true;
+		}
+	}
+	return false;
+}
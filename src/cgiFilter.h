@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include "cgiPacketColumns.h"
+#include "cgiTimeCode.h"
+#include "parallelFor.h"
+
+/// <summary>
+/// Low-pass filtering of encoder noise, a cutoff frequency per channel group
+///  A cutoff is the frequency [Hz] of a half power response, 0 leaves the channels as they are
+/// </summary>
+struct CGIFiltering
+{
+	bool	isEnabled{ false };
+
+	float	translation{ 0.0f };		//!< x, y, z
+	float	rotation{ 5.0f };			//!< pan, tilt, roll
+	float	lens{ 5.0f };				//!< zoom, focus, iris
+	float	trackPos{ 0.0f };
+};
+
+/// <summary>
+/// Symmetric gaussian kernel, the filter has no phase shift, so filtered curves keep the timing of the motion
+///  A sample is filtered with its neighbours of the same segment, samples at the segment ends are repeated
+/// </summary>
+struct CGIFilterKernel
+{
+	static constexpr size_t MAX_RADIUS = 256;
+
+	std::vector<float>	weights;		//!< the center weight first, then a weight per both samples at the distance
+
+	size_t Radius() const { return (weights.empty()) ? 0 : weights.size() - 1; }
+
+	/// <summary>
+	/// kernel of a cutoff frequency for a sample rate, no kernel when the cutoff is above the sample rate resolution
+	/// </summary>
+	void Compute(const double cutoff, const double sampleRate)
+	{
+		weights.clear();
+		if (cutoff <= 0.0 || sampleRate <= 0.0)
+			return;
+
+		// gaussian response is a half power at sqrt(ln 2) / (2 pi sigma)
+		const double sigma = sampleRate * std::sqrt(std::log(2.0)) / (2.0 * pi * cutoff);
+		const size_t radius = std::min(MAX_RADIUS, static_cast<size_t>(std::ceil(3.0 * sigma)));
+		if (radius == 0)
+			return;
+
+		weights.resize(radius + 1);
+		double sum = 0.0;
+		for (size_t k = 0; k <= radius; ++k)
+		{
+			const double w = std::exp(-0.5 * static_cast<double>(k * k) / (sigma * sigma));
+			weights[k] = static_cast<float>(w);
+			sum += (k > 0) ? 2.0 * w : w;
+		}
+		for (float& w : weights)
+			w = static_cast<float>(w / sum);
+	}
+
+	/// <summary>
+	/// filter samples [first; last) of a segment [0; count), output[0] is the filtered source[first]
+	///  the inner loops run over contiguous arrays, so the compiler vectorizes them
+	/// </summary>
+	void Apply(const float* source, const size_t count, const size_t first, const size_t last, float* output) const
+	{
+		const size_t radius = Radius();
+
+		// samples with all taps inside the segment
+		const size_t inner_first = std::min(std::max(first, radius), last);
+		const size_t inner_last = std::max(inner_first, std::min(last, (count > radius) ? count - radius : 0));
+
+		auto fn_clamped = [&](const size_t i) -> float
+			{
+				float value = weights[0] * source[i];
+				for (size_t k = 1; k <= radius; ++k)
+				{
+					const size_t left = (i >= k) ? i - k : 0;
+					const size_t right = std::min(i + k, count - 1);
+					value += weights[k] * (source[left] + source[right]);
+				}
+				return value;
+			};
+
+		for (size_t i = first; i < inner_first; ++i)
+			output[i - first] = fn_clamped(i);
+
+		const size_t n = inner_last - inner_first;
+		const float* center = source + inner_first;
+		float* inner = output + (inner_first - first);
+
+		const float w0 = weights[0];
+		for (size_t j = 0; j < n; ++j)
+			inner[j] = w0 * center[j];
+
+		for (size_t k = 1; k <= radius; ++k)
+		{
+			const float w = weights[k];
+			const float* left = center - k;
+			const float* right = center + k;
+			for (size_t j = 0; j < n; ++j)
+				inner[j] += w * (left[j] + right[j]);
+		}
+
+		for (size_t i = inner_last; i < last; ++i)
+			output[i - first] = fn_clamped(i);
+	}
+};
+
+/// <summary>
+/// number of packets before and after a range the filter reads as context, see FilterColumns
+///  a trimmed load keeps them, so the filtered range is the same as in a load of the whole recording
+/// </summary>
+inline size_t GetFilterContextPackets(const CGIFiltering& filtering)
+{
+	return (filtering.isEnabled) ? CGIFilterKernel::MAX_RADIUS : 0;
+}
+
+/// <summary>
+/// filter continuous channels of sorted packets [first; last) into output columns
+///  packets before and after the range are used as filter context, a data gap (packets more than
+/// a second apart) starts a new segment, the filter never mixes samples of different segments.
+///  Channels and blocks of a long range are filtered in parallel
+/// </summary>
+/// <returns>number of output packets</returns>
+inline size_t FilterColumns(const CGIPacketColumns& columns, const size_t first, const size_t last, const CGIFiltering& filtering,
+	CGIPacketColumns& output)
+{
+	const size_t count = (last > first) ? last - first : 0;
+	output.frameRate = columns.frameRate;
+	output.nominalFrameRate = columns.nominalFrameRate;
+	output.timeCodeRate = columns.timeCodeRate;
+	output.Resize(count);
+
+	if (count == 0)
+		return 0;
+
+	std::copy(begin(columns.packetNumber) + first, begin(columns.packetNumber) + last, begin(output.packetNumber));
+	std::copy(begin(columns.timeCode) + first, begin(columns.timeCode) + last, begin(output.timeCode));
+	std::copy(begin(columns.frameIndex) + first, begin(columns.frameIndex) + last, begin(output.frameIndex));
+	std::copy(begin(columns.keyTime) + first, begin(columns.keyTime) + last, begin(output.keyTime));
+
+	struct Channel
+	{
+		std::vector<float> CGIPacketColumns::*	values;
+		float									cutoff;
+	};
+
+	const Channel channels[] = {
+		{ &CGIPacketColumns::x, filtering.translation }, { &CGIPacketColumns::y, filtering.translation }, { &CGIPacketColumns::z, filtering.translation },
+		{ &CGIPacketColumns::pan, filtering.rotation }, { &CGIPacketColumns::tilt, filtering.rotation }, { &CGIPacketColumns::roll, filtering.rotation },
+		{ &CGIPacketColumns::zoom, filtering.lens }, { &CGIPacketColumns::focus, filtering.lens }, { &CGIPacketColumns::iris, filtering.lens },
+		{ &CGIPacketColumns::trackPos, filtering.trackPos } };
+
+	const size_t numberOfChannels = sizeof(channels) / sizeof(channels[0]);
+
+	// segments between data gaps, a segment extends out of the range up to the kernel context
+	struct Segment
+	{
+		size_t	first;			//!< the segment packets
+		size_t	last;
+		size_t	rangeFirst;		//!< the segment packets within the output range
+		size_t	rangeLast;
+		std::vector<CGIFilterKernel>	kernels;	//!< a kernel per channel
+	};
+
+	const fbx::i64 max_interval = FBX_SECOND_TICKS;
+	const size_t context = CGIFilterKernel::MAX_RADIUS;
+	const size_t columns_count = columns.Count();
+
+	std::vector<Segment> segments;
+	size_t segment_first = first;
+	while (segment_first > 0 && first - segment_first < context && columns.keyTime[segment_first] - columns.keyTime[segment_first - 1] <= max_interval)
+		--segment_first;
+
+	for (size_t i = first; i < last; )
+	{
+		size_t segment_last = i + 1;
+		while (segment_last < columns_count && columns.keyTime[segment_last] - columns.keyTime[segment_last - 1] <= max_interval
+			&& (segment_last < last || segment_last - last < context))
+			++segment_last;
+
+		Segment segment;
+		segment.first = segment_first;
+		segment.last = segment_last;
+		segment.rangeFirst = i;
+		segment.rangeLast = std::min(segment_last, last);
+
+		// packets of a high rate recording share a frame, the sample rate is the number of packets per the frames duration
+		const int64_t frames = columns.frameIndex[segment_last - 1] - columns.frameIndex[segment_first] + 1;
+		const double duration = static_cast<double>(frames) / columns.timeCodeRate.ToDouble();
+		const double sampleRate = static_cast<double>(segment_last - segment_first) / duration;
+
+		segment.kernels.resize(numberOfChannels);
+		for (size_t c = 0; c < numberOfChannels; ++c)
+			segment.kernels[c].Compute(static_cast<double>(channels[c].cutoff), sampleRate);
+
+		i = segment.rangeLast;
+		segment_first = i;
+
+		segments.push_back(std::move(segment));
+	}
+
+	// a task is a block of one channel in one segment
+	struct Task
+	{
+		size_t	channel;
+		size_t	segment;
+		size_t	first;
+		size_t	last;
+	};
+
+	const size_t block_size = 1 << 16;
+	std::vector<Task> tasks;
+	for (size_t c = 0; c < numberOfChannels; ++c)
+	{
+		for (size_t s = 0; s < segments.size(); ++s)
+		{
+			for (size_t i = segments[s].rangeFirst; i < segments[s].rangeLast; i += block_size)
+			{
+				tasks.push_back({ c, s, i, std::min(i + block_size, segments[s].rangeLast) });
+			}
+		}
+	}
+
+	// a parallel block takes whole tasks, short ranges are filtered on the caller thread
+	const size_t min_tasks = std::max<size_t>(1, tasks.size() * (1 << 14) / std::max<size_t>(count * numberOfChannels, 1));
+
+	ParallelFor(tasks.size(), min_tasks, [&](const size_t task_first, const size_t task_last, const size_t)
+		{
+			for (size_t t = task_first; t < task_last; ++t)
+			{
+				const Task& task = tasks[t];
+				const Segment& segment = segments[task.segment];
+				const CGIFilterKernel& kernel = segment.kernels[task.channel];
+
+				const float* source = (columns.*channels[task.channel].values).data();
+				float* filtered = (output.*channels[task.channel].values).data() + (task.first - first);
+
+				if (kernel.Radius() == 0)
+				{
+					std::copy(source + task.first, source + task.last, filtered);
+					continue;
+				}
+
+				kernel.Apply(source + segment.first, segment.last - segment.first, task.first - segment.first, task.last - segment.first, filtered);
+			}
+		});
+
+	return count;
+}
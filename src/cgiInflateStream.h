@@ -0,0 +1,495 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+#include <stdint.h>
+#include "miniz.h"
+#include "cgiLog.h"
+
+/// <summary>
+/// Incremental decompression of an archived cgi recording (.gz or .zip)
+///  Compressed bytes are fed by chunks of any size, decompressed bytes are passed to a callback by chunks
+/// of a fixed size as soon as they are inflated, so neither the compressed nor the decompressed stream has to be
+/// kept in memory as a whole
+///  gzip - every member of the file is inflated one after another, crc and size of a member are checked
+///  zip - the first file entry of the archive is inflated (stored or deflated), directory entries are skipped
+/// </summary>
+class CGIInflateStream
+{
+public:
+
+	typedef std::function<bool(const uint8_t*, size_t)>	OutputCallback;
+
+	enum class Format : uint8_t
+	{
+		None,
+		Gzip,
+		Zip
+	};
+
+	/// <summary>
+	/// format by the stream signature, a few first bytes are enough
+	/// </summary>
+	static Format DetectFormat(const uint8_t* data, size_t size)
+	{
+		if (size >= 3 && data[0] == 0x1f && data[1] == 0x8b && data[2] == 8)
+			return Format::Gzip;
+		if (size >= 4 && ReadU32(data) == ZIP_LOCAL_HEADER_SIGNATURE)
+			return Format::Zip;
+		return Format::None;
+	}
+
+	static bool IsCompressed(const uint8_t* data, size_t size) { return DetectFormat(data, size) != Format::None; }
+
+	CGIInflateStream(OutputCallback callback, const size_t output_chunk_size = 1 << 16)
+		: m_Callback(callback)
+		, m_Output(std::max(output_chunk_size, static_cast<size_t>(1024)))
+	{}
+
+	~CGIInflateStream()
+	{
+		EndInflate();
+	}
+
+	CGIInflateStream(const CGIInflateStream&) = delete;
+	CGIInflateStream& operator=(const CGIInflateStream&) = delete;
+
+	/// <summary>
+	/// process next chunk of the compressed stream, returns false on a damaged stream
+	///  or when the output callback returns false
+	/// </summary>
+	bool Feed(const uint8_t* data, size_t size)
+	{
+		if (m_HasError)
+			return false;
+
+		if (m_Format == Format::None && size > 0)
+		{
+			m_Format = DetectFormat(data, size);
+			if (m_Format == Format::None)
+				return SetError("Unknown compressed stream format");
+		}
+
+		while (size > 0 && !m_HasError && m_State != State::Done)
+		{
+			size_t consumed = 0;
+			switch (m_State)
+			{
+			case State::Header:
+				consumed = ConsumeHeader(data, size);
+				break;
+			case State::Inflate:
+				consumed = ConsumeDeflated(data, size);
+				break;
+			case State::Stored:
+				consumed = ConsumeStored(data, size);
+				break;
+			case State::Skip:
+				consumed = std::min(size, static_cast<size_t>(m_RemainingBytes));
+				m_RemainingBytes -= consumed;
+				if (m_RemainingBytes == 0)
+					m_State = State::Header;
+				break;
+			case State::Trailer:
+				consumed = ConsumeTrailer(data, size);
+				break;
+			default:
+				break;
+			}
+
+			data += consumed;
+			size -= consumed;
+		}
+		return !m_HasError;
+	}
+
+	/// <summary>
+	/// check the end of the compressed stream, returns false if the stream is truncated
+	/// </summary>
+	bool Finish()
+	{
+		if (m_HasError)
+			return false;
+
+		// the last chunk of deflated data could leave inflated bytes in the dictionary
+		if (m_State == State::Inflate)
+			ConsumeDeflated(nullptr, 0);
+
+		if (m_HasError)
+			return false;
+
+		const bool is_complete = (m_State == State::Done)
+			|| (m_Format == Format::Gzip && m_State == State::Header && m_Header.empty() && m_NumberOfMembers > 0);
+
+		if (!is_complete)
+			return SetError((m_NumberOfMembers == 0 && m_Format == Format::Zip && m_State == State::Header)
+				? "Zip archive has no recording" : "Compressed stream is truncated");
+		return true;
+	}
+
+	bool HasError() const { return m_HasError; }
+
+	Format GetFormat() const { return m_Format; }
+
+	/// <summary>
+	/// number of decompressed bytes passed to the callback so far
+	/// </summary>
+	uint64_t GetNumberOfOutputBytes() const { return m_NumberOfOutputBytes; }
+
+private:
+
+	static constexpr uint32_t ZIP_LOCAL_HEADER_SIGNATURE = 0x04034b50;
+	static constexpr size_t ZIP_LOCAL_HEADER_SIZE = 30;
+	static constexpr size_t GZIP_HEADER_SIZE = 10;
+	static constexpr size_t GZIP_TRAILER_SIZE = 8;
+
+	enum class State : uint8_t
+	{
+		Header,		//!< gzip member header or zip local file header
+		Inflate,	//!< deflated data
+		Stored,		//!< zip entry without compression
+		Skip,		//!< zip entry which is not a recording
+		Trailer,	//!< gzip crc and size
+		Done
+	};
+
+	Format				m_Format{ Format::None };
+	State				m_State{ State::Header };
+	OutputCallback		m_Callback;
+	bool				m_HasError{ false };
+
+	mz_stream			m_Stream;
+	bool				m_IsInflateStarted{ false };
+
+	std::vector<uint8_t>	m_Header;		//!< a header or a trailer collected over chunks
+	std::vector<uint8_t>	m_Output;
+
+	uint64_t			m_RemainingBytes{ 0 };		//!< of a stored or a skipped zip entry
+	uint32_t			m_ExpectedCrc{ 0 };
+	bool				m_HasExpectedCrc{ false };
+	mz_ulong			m_Crc{ 0 };
+	uint64_t			m_MemberSize{ 0 };
+	size_t				m_NumberOfMembers{ 0 };
+	uint64_t			m_NumberOfOutputBytes{ 0 };
+
+	static uint16_t ReadU16(const uint8_t* p)
+	{
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+	static uint32_t ReadU32(const uint8_t* p)
+	{
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+			| (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	bool SetError(const char* message)
+	{
+		LogPrintf("loadCGI ERROR: %s\n", message);
+		m_HasError = true;
+		EndInflate();
+		return false;
+	}
+
+	bool StartInflate()
+	{
+		memset(&m_Stream, 0, sizeof(mz_stream));
+		// raw deflate, gzip and zip headers are parsed here
+		if (mz_inflateInit2(&m_Stream, -MZ_DEFAULT_WINDOW_BITS) != MZ_OK)
+			return SetError("Failed to initialize the decompression");
+		m_IsInflateStarted = true;
+		return true;
+	}
+
+	void EndInflate()
+	{
+		if (m_IsInflateStarted)
+		{
+			mz_inflateEnd(&m_Stream);
+			m_IsInflateStarted = false;
+		}
+	}
+
+	void StartMember()
+	{
+		m_Crc = mz_crc32(0, nullptr, 0);
+		m_MemberSize = 0;
+	}
+
+	bool Emit(const uint8_t* data, size_t size)
+	{
+		if (size == 0)
+			return true;
+
+		m_Crc = mz_crc32(m_Crc, data, size);
+		m_MemberSize += size;
+		m_NumberOfOutputBytes += size;
+
+		if (m_Callback && !m_Callback(data, size))
+		{
+			m_HasError = true;
+			EndInflate();
+			return false;
+		}
+		return true;
+	}
+
+	bool EndMember()
+	{
+		m_NumberOfMembers += 1;
+		if (m_HasExpectedCrc && static_cast<uint32_t>(m_Crc) != m_ExpectedCrc)
+			return SetError("Compressed stream crc mismatch");
+		return true;
+	}
+
+	/// <summary>
+	/// collect the header over chunks, returns a number of consumed bytes
+	/// </summary>
+	size_t ConsumeHeader(const uint8_t* data, size_t size)
+	{
+		const size_t old_size = m_Header.size();
+		const size_t appended = std::min(size, static_cast<size_t>(64 * 1024));
+		m_Header.insert(end(m_Header), data, data + appended);
+
+		size_t header_size = 0;
+		const bool status = (m_Format == Format::Gzip) ? ParseGzipHeader(header_size) : ParseZipHeader(header_size);
+
+		if (!status || m_HasError)
+			return appended;
+		if (header_size == 0)
+		{
+			// a header can't be that long, except a zip entry with a huge extra field
+			if (m_Header.size() > (1 << 20))
+				SetError("Compressed stream header is too long");
+			return appended;
+		}
+
+		m_Header.clear();
+		return header_size - old_size;
+	}
+
+	/// <summary>
+	/// parse the gzip member header, header_size is 0 when more bytes are needed
+	/// </summary>
+	bool ParseGzipHeader(size_t& header_size)
+	{
+		enum { FHCRC = 2, FEXTRA = 4, FNAME = 8, FCOMMENT = 16, FRESERVED = 0xe0 };
+
+		const uint8_t* p = m_Header.data();
+		const size_t size = m_Header.size();
+
+		static const uint8_t signature[] = { 0x1f, 0x8b, 8 };
+		const bool is_valid = memcmp(p, signature, std::min(size, sizeof(signature))) == 0
+			&& (size < 4 || (p[3] & FRESERVED) == 0);
+
+		header_size = 0;
+		if (!is_valid)
+		{
+			if (m_NumberOfMembers > 0)
+			{
+				// as gzip does, trailing garbage after the last member is ignored
+				m_Header.clear();
+				m_State = State::Done;
+				return false;
+			}
+			return SetError("Wrong gzip header");
+		}
+		if (size < GZIP_HEADER_SIZE)
+			return true;
+
+		const uint8_t flags = p[3];
+		size_t pos = GZIP_HEADER_SIZE;
+
+		if (flags & FEXTRA)
+		{
+			if (size < pos + 2)
+				return true;
+			pos += 2 + ReadU16(p + pos);
+		}
+		if (flags & FNAME)
+		{
+			const uint8_t* zero = (pos < size) ? static_cast<const uint8_t*>(memchr(p + pos, 0, size - pos)) : nullptr;
+			if (zero == nullptr)
+				return true;
+			pos = static_cast<size_t>(zero - p) + 1;
+		}
+		if (flags & FCOMMENT)
+		{
+			const uint8_t* zero = (pos < size) ? static_cast<const uint8_t*>(memchr(p + pos, 0, size - pos)) : nullptr;
+			if (zero == nullptr)
+				return true;
+			pos = static_cast<size_t>(zero - p) + 1;
+		}
+		if (flags & FHCRC)
+			pos += 2;
+
+		if (size < pos)
+			return true;
+
+		header_size = pos;
+		m_HasExpectedCrc = false;
+		StartMember();
+		m_State = State::Inflate;
+		return StartInflate();
+	}
+
+	/// <summary>
+	/// parse the zip local file header, header_size is 0 when more bytes are needed
+	/// </summary>
+	bool ParseZipHeader(size_t& header_size)
+	{
+		enum { FLAG_ENCRYPTED = 1, FLAG_DATA_DESCRIPTOR = 8 };
+		enum { METHOD_STORED = 0, METHOD_DEFLATED = 8 };
+
+		const uint8_t* p = m_Header.data();
+		const size_t size = m_Header.size();
+
+		header_size = 0;
+		if (size < 4)
+			return true;
+		if (ReadU32(p) != ZIP_LOCAL_HEADER_SIGNATURE)
+		{
+			// central directory, there are no more file entries
+			return SetError("Zip archive has no recording");
+		}
+		if (size < ZIP_LOCAL_HEADER_SIZE)
+			return true;
+
+		const uint16_t flags = ReadU16(p + 6);
+		const uint16_t method = ReadU16(p + 8);
+		const uint32_t crc = ReadU32(p + 14);
+		const uint32_t compressed_size = ReadU32(p + 18);
+		const size_t name_length = ReadU16(p + 26);
+		const size_t extra_length = ReadU16(p + 28);
+
+		const size_t total_size = ZIP_LOCAL_HEADER_SIZE + name_length + extra_length;
+		if (size < total_size)
+			return true;
+
+		header_size = total_size;
+
+		const bool is_directory = name_length > 0 && (p[ZIP_LOCAL_HEADER_SIZE + name_length - 1] == '/');
+		if (is_directory)
+		{
+			if (flags & FLAG_DATA_DESCRIPTOR)
+				return SetError("Unsupported zip directory entry");
+			m_RemainingBytes = compressed_size;
+			m_State = (compressed_size > 0) ? State::Skip : State::Header;
+			return true;
+		}
+
+		if (flags & FLAG_ENCRYPTED)
+			return SetError("Encrypted zip archives are not supported");
+
+		m_HasExpectedCrc = (flags & FLAG_DATA_DESCRIPTOR) == 0;
+		m_ExpectedCrc = crc;
+		StartMember();
+
+		if (method == METHOD_DEFLATED)
+		{
+			m_State = State::Inflate;
+			return StartInflate();
+		}
+		else if (method == METHOD_STORED)
+		{
+			if ((flags & FLAG_DATA_DESCRIPTOR) || compressed_size == 0xffffffff)
+				return SetError("Unsupported stored zip entry");
+
+			m_RemainingBytes = compressed_size;
+			m_State = State::Stored;
+			if (m_RemainingBytes == 0)
+			{
+				m_State = State::Done;
+				return EndMember();
+			}
+			return true;
+		}
+		return SetError("Unsupported zip compression method");
+	}
+
+	size_t ConsumeDeflated(const uint8_t* data, size_t size)
+	{
+		m_Stream.next_in = data;
+		m_Stream.avail_in = static_cast<unsigned int>(std::min(size, static_cast<size_t>(UINT32_MAX)));
+
+		int status = MZ_OK;
+		do
+		{
+			m_Stream.next_out = m_Output.data();
+			m_Stream.avail_out = static_cast<unsigned int>(m_Output.size());
+
+			status = mz_inflate(&m_Stream, MZ_NO_FLUSH);
+			if (status != MZ_OK && status != MZ_STREAM_END && status != MZ_BUF_ERROR)
+			{
+				SetError("Damaged compressed stream");
+				return size;
+			}
+
+			if (!Emit(m_Output.data(), m_Output.size() - m_Stream.avail_out))
+				return size;
+
+			// a full output buffer could leave inflated bytes behind, so inflate again
+		} while (status == MZ_OK && (m_Stream.avail_in > 0 || m_Stream.avail_out == 0));
+
+		const size_t consumed = size - m_Stream.avail_in;
+
+		if (status == MZ_STREAM_END)
+		{
+			EndInflate();
+			if (m_Format == Format::Gzip)
+			{
+				m_State = State::Trailer;
+			}
+			else
+			{
+				m_State = State::Done;
+				EndMember();
+			}
+		}
+		return consumed;
+	}
+
+	size_t ConsumeStored(const uint8_t* data, size_t size)
+	{
+		const size_t consumed = std::min(size, static_cast<size_t>(m_RemainingBytes));
+		m_RemainingBytes -= consumed;
+
+		if (!Emit(data, consumed))
+			return size;
+
+		if (m_RemainingBytes == 0)
+		{
+			m_State = State::Done;
+			EndMember();
+		}
+		return consumed;
+	}
+
+	/// <summary>
+	/// gzip member ends with crc32 and a size modulo 2^32 of the uncompressed data
+	/// </summary>
+	size_t ConsumeTrailer(const uint8_t* data, size_t size)
+	{
+		const size_t consumed = std::min(size, GZIP_TRAILER_SIZE - m_Header.size());
+		m_Header.insert(end(m_Header), data, data + consumed);
+
+		if (m_Header.size() == GZIP_TRAILER_SIZE)
+		{
+			m_HasExpectedCrc = true;
+			m_ExpectedCrc = ReadU32(m_Header.data());
+			const uint32_t member_size = ReadU32(m_Header.data() + 4);
+			m_Header.clear();
+
+			if (member_size != static_cast<uint32_t>(m_MemberSize))
+			{
+				SetError("Compressed stream size mismatch");
+				return size;
+			}
+			if (EndMember())
+				m_State = State::Header;
+		}
+		return consumed;
+	}
+};
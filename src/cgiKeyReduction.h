@@ -0,0 +1,31 @@
+#pragma once
+
+/// <summary>
+/// Tolerances of the exported curves key reduction, see AnimationCurve::ReduceKeys
+///  A tolerance is the largest allowed difference of a curve value, in the units of the curve.
+///  Packet number and timecode curves are constant, they keep every value change
+/// </summary>
+struct CGIKeyReduction
+{
+	bool	isEnabled{ false };
+
+	float	translation{ 0.01f };		//!< [cm]
+	float	rotation{ 0.005f };			//!< [degrees]
+	float	focalLength{ 0.01f };		//!< [mm]
+	float	focusDistance{ 0.1f };		//!< [cm]
+	float	lens{ 0.0001f };			//!< raw zoom, focus and iris values
+	float	trackPos{ 0.0001f };		//!< [m]
+
+	/// <summary>
+	/// multiply all tolerances, a scale above 1 removes more keys
+	/// </summary>
+	void Scale(const float scale)
+	{
+		translation *= scale;
+		rotation *= scale;
+		focalLength *= scale;
+		focusDistance *= scale;
+		lens *= scale;
+		trackPos *= scale;
+	}
+};
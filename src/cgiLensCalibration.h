@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <stdint.h>
+
+/// <summary>
+/// Calibration of a lens, encoder values of an uncalibrated rig with the lens values they stand for
+///  A text table has a calibration point per line, points of a channel can go in any order
+///   zoom <encoder> <focal length in mm>
+///   focus <encoder> <focus distance in m>
+///   iris <encoder> <T-stop>
+///  empty lines and lines starting with # are skipped
+/// </summary>
+struct CGILensCalibration
+{
+	typedef std::vector<std::pair<float, float>>	Points;
+
+	Points	zoom;		//!< encoder, focal length [mm]
+	Points	focus;		//!< encoder, focus distance [m]
+	Points	iris;		//!< encoder, T-stop
+
+	/// chip size [mm] of the camera, the FieldOfView curve gets the vertical field of view of a known chip size,
+	/// otherwise the focal length
+	float	chipWidth{ 0.0f };
+	float	chipHeight{ 0.0f };
+
+	bool HasChipSize() const { return chipWidth > 0.0f && chipHeight > 0.0f; }
+	bool IsEmpty() const { return zoom.empty() && focus.empty() && iris.empty(); }
+
+	/// <summary>
+	/// parse a calibration table text, the channel points are sorted by encoder values
+	/// </summary>
+	bool Parse(const char* text)
+	{
+		zoom.clear();
+		focus.clear();
+		iris.clear();
+
+		std::istringstream stream(text);
+		std::string line;
+		int lineNumber = 0;
+
+		while (std::getline(stream, line))
+		{
+			lineNumber += 1;
+
+			std::istringstream lineStream(line);
+			std::string channel;
+			if (!(lineStream >> channel) || channel[0] == '#')
+				continue;
+
+			float encoder = 0.0f;
+			float value = 0.0f;
+			Points* points = (channel == "zoom") ? &zoom : (channel == "focus") ? &focus : (channel == "iris") ? &iris : nullptr;
+
+			if (points == nullptr || !(lineStream >> encoder >> value))
+			{
+				printf("Wrong lens calibration line %d - %s\n", lineNumber, line.c_str());
+				return false;
+			}
+			points->emplace_back(encoder, value);
+		}
+
+		for (Points* points : { &zoom, &focus, &iris })
+			std::sort(begin(*points), end(*points));
+		return !IsEmpty();
+	}
+
+	bool Load(const char* filename)
+	{
+		std::ifstream file(filename);
+		if (!file.is_open())
+			return false;
+
+		std::stringstream text;
+		text << file.rdbuf();
+		return Parse(text.str().c_str());
+	}
+};
+
+/// <summary>
+/// Uniform lookup table of an encoder range, a lens function is evaluated once per table entry
+///  and a packet value is a linear interpolation of two neighbour entries, so a batch of packets
+///  needs no divisions or transcendental functions per packet
+/// </summary>
+class CGILensLUT
+{
+public:
+
+	static constexpr size_t LUT_SIZE = 4096;
+
+	bool IsEmpty() const { return m_Values.empty(); }
+
+	/// <summary>
+	/// table of a function over the encoder range [first; last]
+	/// </summary>
+	void Build(const float first, const float last, const std::function<double(double)>& fn)
+	{
+		m_First = first;
+		m_Step = (last > first) ? (last - first) / static_cast<float>(LUT_SIZE - 1) : 1.0f;
+		m_InvStep = 1.0f / m_Step;
+		m_Values.resize(LUT_SIZE);
+
+		for (size_t i = 0; i < LUT_SIZE; ++i)
+			m_Values[i] = static_cast<float>(fn(static_cast<double>(m_First) + static_cast<double>(m_Step) * static_cast<double>(i)));
+	}
+
+	/// <summary>
+	/// table of calibration points sorted by encoder, a lens value between points is linear,
+	///  the mapped function applies to the interpolated lens value (like a focal length into a field of view)
+	/// </summary>
+	void Build(const CGILensCalibration::Points& points, const std::function<double(double)>& fn)
+	{
+		m_Values.clear();
+		if (points.empty())
+			return;
+
+		size_t j = 0;
+		Build(points.front().first, points.back().first, [&points, &fn, &j](const double encoder) -> double
+			{
+				// entries go in the encoder order, the point interval only moves forward
+				while (j + 2 < points.size() && static_cast<double>(points[j + 1].first) <= encoder)
+					++j;
+
+				const size_t j1 = std::min(j + 1, points.size() - 1);
+				const double e0 = points[j].first;
+				const double e1 = points[j1].first;
+				const double t = (e1 > e0) ? std::min(std::max((encoder - e0) / (e1 - e0), 0.0), 1.0) : 0.0;
+				return fn(static_cast<double>(points[j].second) * (1.0 - t) + static_cast<double>(points[j1].second) * t);
+			});
+	}
+
+	/// <summary>
+	/// output[i] = table value of input[i], encoder values out of the range get the end values
+	/// </summary>
+	void Evaluate(const float* input, const size_t count, float* output) const
+	{
+		const float* values = m_Values.data();
+		const float first = m_First;
+		const float invStep = m_InvStep;
+		const float maxPosition = static_cast<float>(LUT_SIZE - 1);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float position = std::min(std::max((input[i] - first) * invStep, 0.0f), maxPosition);
+			const size_t index = std::min(static_cast<size_t>(position), LUT_SIZE - 2);
+			const float t = position - static_cast<float>(index);
+			output[i] = values[index] + t * (values[index + 1] - values[index]);
+		}
+	}
+
+private:
+
+	float	m_First{ 0.0f };
+	float	m_Step{ 1.0f };
+	float	m_InvStep{ 1.0f };
+	std::vector<float>	m_Values;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <cstdio>
+#include <cstdarg>
+
+/// <summary>
+/// log buffer of the current thread, nullptr - the log goes straight to stdout
+/// </summary>
+inline std::string*& GetThreadLogBuffer()
+{
+	static thread_local std::string* buffer = nullptr;
+	return buffer;
+}
+
+/// <summary>
+/// printf into the log buffer of the current thread, see CGILogScope, or into stdout
+/// </summary>
+inline void LogPrintf(const char* format, ...)
+{
+	va_list args;
+	va_start(args, format);
+
+	std::string* buffer = GetThreadLogBuffer();
+	if (buffer == nullptr)
+	{
+		vprintf(format, args);
+	}
+	else
+	{
+		va_list args_copy;
+		va_copy(args_copy, args);
+		const int length = vsnprintf(nullptr, 0, format, args_copy);
+		va_end(args_copy);
+
+		if (length > 0)
+		{
+			const size_t offset = buffer->size();
+			buffer->resize(offset + static_cast<size_t>(length) + 1);
+			vsnprintf(&(*buffer)[offset], static_cast<size_t>(length) + 1, format, args);
+			buffer->resize(offset + static_cast<size_t>(length));
+		}
+	}
+	va_end(args);
+}
+
+/// <summary>
+/// Log of a job which runs in parallel with other jobs, LogPrintf calls of the thread are collected
+///  in the job buffer while the scope is alive, so the job prints the whole log at once when it's finished
+/// </summary>
+class CGILogScope
+{
+public:
+
+	explicit CGILogScope(std::string& buffer)
+		: m_Previous(GetThreadLogBuffer())
+	{
+		GetThreadLogBuffer() = &buffer;
+	}
+
+	~CGILogScope()
+	{
+		GetThreadLogBuffer() = m_Previous;
+	}
+
+	CGILogScope(const CGILogScope&) = delete;
+	CGILogScope& operator=(const CGILogScope&) = delete;
+
+private:
+
+	std::string*	m_Previous;
+};
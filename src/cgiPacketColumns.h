@@ -0,0 +1,194 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include "cgidata.h"
+#include "fbxtypes.h"
+#include "cgiTimeCode.h"
+
+/// <summary>
+/// Columnar (structure of arrays) copy of packets sorted by timecode
+///  Every channel is a contiguous array, so a processing pass reads only the channels it needs
+/// and a loop over a column is simple enough for the compiler to vectorize
+/// </summary>
+struct CGIPacketColumns
+{
+	std::vector<float>	x, y, z;				//!< [m]
+	std::vector<float>	pan, tilt, roll;		//!< [degrees]
+	std::vector<float>	zoom, focus, iris;		//!< raw lens values
+	std::vector<float>	trackPos;
+
+	std::vector<u32>	packetNumber;
+	std::vector<timeCodeStruct>	timeCode;
+
+	std::vector<int64_t>	frameIndex;		//!< timecode as a number of frames since midnight, see TimeCodeToFrameCount
+	std::vector<fbx::i64>	keyTime;		//!< frame index as fbx time, see FrameCountToKeyTime
+
+	double	frameRate{ 0.0 };				//!< frame rate used for frame index and key time
+	int		nominalFrameRate{ 0 };			//!< number of frames in a timecode second (30 for 29.97)
+	CGIFrameRate	timeCodeRate;			//!< exact frame rate of timecodes
+
+	size_t Count() const { return packetNumber.size(); }
+	bool IsEmpty() const { return packetNumber.empty(); }
+
+	void SetFrameRate(const double frame_rate)
+	{
+		frameRate = frame_rate;
+		timeCodeRate = CGIFrameRate::FromDouble(frame_rate);
+		nominalFrameRate = timeCodeRate.nominal;
+	}
+
+	void Resize(const size_t count)
+	{
+		x.resize(count);
+		y.resize(count);
+		z.resize(count);
+		pan.resize(count);
+		tilt.resize(count);
+		roll.resize(count);
+		zoom.resize(count);
+		focus.resize(count);
+		iris.resize(count);
+		trackPos.resize(count);
+		packetNumber.resize(count);
+		timeCode.resize(count);
+		frameIndex.resize(count);
+		keyTime.resize(count);
+	}
+
+	void Clear()
+	{
+		Resize(0);
+		frameRate = 0.0;
+		nominalFrameRate = 0;
+	}
+
+	/// <summary>
+	/// fill values at a given index from a packet, the frame rate has to be set before
+	/// </summary>
+	void Set(const size_t index, const CGIDataCartesian& packet)
+	{
+		x[index] = packet.x;
+		y[index] = packet.y;
+		z[index] = packet.z;
+		pan[index] = packet.pan;
+		tilt[index] = packet.tilt;
+		roll[index] = packet.roll;
+		zoom[index] = packet.zoom;
+		focus[index] = packet.focus;
+		iris[index] = packet.iris;
+		trackPos[index] = packet.spare.trackPos;
+		packetNumber[index] = packet.packetNumber;
+
+		const timeCodeStruct tc = packet.timeCode;
+		timeCode[index] = tc;
+
+		frameIndex[index] = TimeCodeToFrameCount(tc, timeCodeRate);
+		keyTime[index] = FrameCountToKeyTime(frameIndex[index], timeCodeRate);
+	}
+
+	/// <summary>
+	/// key time of a packet in seconds, as OFBTime::GetSecondDouble returns it
+	/// </summary>
+	double GetKeySecond(const size_t index) const
+	{
+		return KeyTimeToSeconds(keyTime[index]);
+	}
+
+	/// <summary>
+	/// drop frame flag of the recording timecodes, trim labels are counted the same way
+	/// </summary>
+	bool IsDropFrame() const { return !timeCode.empty() && timeCode.front().dropFrame != 0; }
+
+	/// <summary>
+	/// binary search of the packets range [first; last) with a timecode label within [start_time; end_time] seconds
+	///  frame indices of sorted packets are non decreasing, the search is O(log n) and compares integer frame counts,
+	/// see LabelSecondsToFrameCount
+	/// </summary>
+	void FindTimeRange(const double start_time, const double end_time, size_t& first, size_t& last) const
+	{
+		const int64_t start_frame = LabelSecondsToFrameCount(start_time, timeCodeRate, IsDropFrame(), false);
+		const int64_t end_frame = LabelSecondsToFrameCount(end_time, timeCodeRate, IsDropFrame(), true);
+
+		const auto first_iter = std::lower_bound(begin(frameIndex), end(frameIndex), start_frame);
+		const auto last_iter = std::upper_bound(first_iter, end(frameIndex), end_frame);
+
+		first = static_cast<size_t>(first_iter - begin(frameIndex));
+		last = static_cast<size_t>(last_iter - begin(frameIndex));
+	}
+
+	/// <summary>
+	/// packets ranges of many time ranges at once, the same result as FindTimeRange for every range
+	///  range bounds are merged against the packets in a sorted order, so every bound is searched
+	/// onwards from the previous one
+	/// </summary>
+	void FindTimeRanges(const std::vector<std::pair<double, double>>& time_ranges, std::vector<std::pair<size_t, size_t>>& ranges) const
+	{
+		const size_t count = time_ranges.size();
+		ranges.resize(count);
+
+		std::vector<size_t> order(count);
+		for (size_t i = 0; i < count; ++i)
+			order[i] = i;
+
+		const bool drop_frame = IsDropFrame();
+
+		// start bounds, first frame index >= start
+		std::sort(begin(order), end(order), [&time_ranges](const size_t a, const size_t b) { return time_ranges[a].first < time_ranges[b].first; });
+
+		size_t pos = 0;
+		for (const size_t i : order)
+		{
+			const int64_t start_frame = LabelSecondsToFrameCount(time_ranges[i].first, timeCodeRate, drop_frame, false);
+			pos = GallopSearch(pos, [this, start_frame](const size_t index) { return frameIndex[index] < start_frame; });
+			ranges[i].first = pos;
+		}
+
+		// end bounds, first frame index > end
+		std::sort(begin(order), end(order), [&time_ranges](const size_t a, const size_t b) { return time_ranges[a].second < time_ranges[b].second; });
+
+		pos = 0;
+		for (const size_t i : order)
+		{
+			const int64_t end_frame = LabelSecondsToFrameCount(time_ranges[i].second, timeCodeRate, drop_frame, true);
+			pos = GallopSearch(pos, [this, end_frame](const size_t index) { return frameIndex[index] <= end_frame; });
+			ranges[i].second = std::max(pos, ranges[i].first);
+		}
+	}
+
+private:
+
+	/// <summary>
+	/// exponential search of the first packet from pos for which is_before is false
+	///  is_before has to be true for a prefix of the packets and false for the rest
+	/// </summary>
+	template<typename F>
+	size_t GallopSearch(const size_t pos, F&& is_before) const
+	{
+		const size_t count = keyTime.size();
+
+		size_t low = pos;
+		size_t high = pos;
+		size_t step = 1;
+		while (high < count && is_before(high))
+		{
+			low = high + 1;
+			high = pos + step;
+			step *= 2;
+		}
+		high = std::min(high, count);
+
+		while (low < high)
+		{
+			const size_t middle = low + (high - low) / 2;
+			if (is_before(middle))
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+};
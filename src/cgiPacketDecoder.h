@@ -0,0 +1,138 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include "cgidata.h"
+#include "cgiPacketScan.h"
+
+/// <summary>
+/// Packet framing of a raw binary cgi stream (serial port, udp, file chunks)
+///  The same state machine as fillData, but the sync state is owned by the decoder,
+/// so every stream (crane) can have its own decoder and decode it on its own thread
+///  Bytes are processed in bulk - the sync word is searched with simd scan and packet
+/// payload is copied at once instead of a call per received byte
+/// </summary>
+class CGIPacketDecoder
+{
+public:
+
+	CGIPacketDecoder()
+	{
+		Reset();
+	}
+
+	/// <summary>
+	/// drop a partially received packet and wait for the next sync word
+	/// </summary>
+	void Reset()
+	{
+		resetSyncState(&m_SyncState);
+		memset(&m_Packet, 0, sizeof(CGIDataCartesian));
+	}
+
+	/// <summary>
+	/// process received bytes, all complete packets with a valid check sum are appended to the packets array
+	/// </summary>
+	/// <returns>number of appended packets</returns>
+	size_t Feed(const u8* input, size_t size, std::vector<CGIDataCartesian>& packets)
+	{
+		const size_t packets_before = packets.size();
+		size_t pos = 0;
+
+		while (pos < size)
+		{
+			if (m_SyncState.state == SM_SYNC_HAPPENED)
+			{
+				// copy as much of the packet payload as we have
+				const size_t bytes_to_copy = std::min(static_cast<size_t>(CGI_DATA_LENGTH - m_SyncState.charIndex), size - pos);
+				memcpy(reinterpret_cast<u8*>(&m_Packet) + m_SyncState.charIndex, input + pos, bytes_to_copy);
+				m_SyncState.charIndex += static_cast<u16>(bytes_to_copy);
+				pos += bytes_to_copy;
+
+				if (m_SyncState.charIndex == CGI_DATA_LENGTH)
+				{
+					m_SyncState.state = SM_WAIT_1;
+					OnPacketReceived(packets);
+				}
+			}
+			else if (m_SyncState.state == SM_WAIT_1 && size - pos >= sizeof(u32))
+			{
+				// jump over the garbage right to the next complete sync word
+				const size_t sync_offset = FindSyncWord(input, size, pos);
+				if (sync_offset < size)
+				{
+					BeginPacket();
+					pos = sync_offset + sizeof(u32);
+				}
+				else
+				{
+					// a sync word could start in the last bytes and continue in the next block
+					pos = size - (sizeof(u32) - 1);
+					for (; pos < size; ++pos)
+						fillDataWithState(&m_SyncState, input[pos], &m_Packet);
+				}
+			}
+			else
+			{
+				// in the middle of a sync word
+				fillDataWithState(&m_SyncState, input[pos], &m_Packet);
+				if (m_SyncState.state == SM_SYNC_HAPPENED)
+					m_Packet.syncVal = TDDE_SYNC_VAL;
+				++pos;
+			}
+		}
+
+		return packets.size() - packets_before;
+	}
+
+	/// <summary>
+	/// process received bytes and return complete packets
+	/// </summary>
+	std::vector<CGIDataCartesian> Feed(const u8* input, size_t size)
+	{
+		std::vector<CGIDataCartesian> packets;
+		Feed(input, size, packets);
+		return packets;
+	}
+
+	/// <summary>
+	/// true if a packet is partially received
+	/// </summary>
+	bool HasPendingData() const { return m_SyncState.state != SM_WAIT_1; }
+
+	size_t GetNumberOfCheckSumErrors() const { return m_NumberOfCheckSumErrors; }
+
+private:
+
+	binaryDataSyncState	m_SyncState;
+	CGIDataCartesian	m_Packet;
+
+	size_t				m_NumberOfCheckSumErrors{ 0 };
+
+	void BeginPacket()
+	{
+		m_SyncState.state = SM_SYNC_HAPPENED;
+		m_SyncState.charIndex = static_cast<u16>(offsetOfFirstCGIDatum);
+		m_Packet.syncVal = TDDE_SYNC_VAL;
+	}
+
+	void OnPacketReceived(std::vector<CGIDataCartesian>& packets)
+	{
+		if (checkSum(&m_Packet, CGI_DATA_LENGTH) == m_Packet.checkSum)
+		{
+			packets.push_back(m_Packet);
+			return;
+		}
+
+		m_NumberOfCheckSumErrors += 1;
+
+		// a false or damaged sync, the next real sync word could be inside of the rejected payload
+		u8 payload[CGI_DATA_LENGTH];
+		const size_t payload_size = CGI_DATA_LENGTH - offsetOfFirstCGIDatum;
+		memcpy(payload, reinterpret_cast<const u8*>(&m_Packet) + offsetOfFirstCGIDatum, payload_size);
+
+		// payload is shorter than a packet, so it can't complete another packet and recurse again
+		Feed(payload, payload_size, packets);
+	}
+};
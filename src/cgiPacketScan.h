@@ -0,0 +1,261 @@
+#pragma once
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+#include <stddef.h>
+#include "cgidata.h"
+
+// pick the widest simd instruction set enabled for the build
+
+#if defined(__AVX2__)
+#define CGI_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CGI_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__wasm_simd128__)
+#define CGI_SIMD_WASM
+#include <wasm_simd128.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/// <summary>
+/// index of the lowest set bit, mask must be non zero
+/// </summary>
+inline int LowestBitIndex(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+/// <summary>
+/// find the first byte offset (starting from a given one) where a TDDE_SYNC_VAL word begins
+///  the offset can be unaligned, the sync word is tested in all byte positions at once
+/// </summary>
+/// <returns>offset of the sync word or size if there is no sync word</returns>
+inline size_t FindSyncWord(const uint8_t* data, const size_t size, size_t offset)
+{
+	if (size < 4)
+		return size;
+
+#if defined(CGI_SIMD_AVX2)
+	const __m256i sync1 = _mm256_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_1));
+	const __m256i sync2 = _mm256_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_2));
+	const __m256i sync3 = _mm256_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_3));
+	const __m256i sync4 = _mm256_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_4));
+
+	for (; offset + 3 + 32 <= size; offset += 32)
+	{
+		const uint8_t* ptr = data + offset;
+		__m256i match = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)), sync1);
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + 1)), sync2));
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + 2)), sync3));
+		match = _mm256_and_si256(match, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr + 3)), sync4));
+
+		const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+		if (mask != 0)
+			return offset + LowestBitIndex(mask);
+	}
+#elif defined(CGI_SIMD_SSE2)
+	const __m128i sync1 = _mm_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_1));
+	const __m128i sync2 = _mm_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_2));
+	const __m128i sync3 = _mm_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_3));
+	const __m128i sync4 = _mm_set1_epi8(static_cast<char>(TDDE_SYNC_VAL_4));
+
+	for (; offset + 3 + 16 <= size; offset += 16)
+	{
+		const uint8_t* ptr = data + offset;
+		__m128i match = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)), sync1);
+		match = _mm_and_si128(match, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 1)), sync2));
+		match = _mm_and_si128(match, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 2)), sync3));
+		match = _mm_and_si128(match, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + 3)), sync4));
+
+		const uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+		if (mask != 0)
+			return offset + LowestBitIndex(mask);
+	}
+#elif defined(CGI_SIMD_WASM)
+	const v128_t sync1 = wasm_i8x16_splat(static_cast<int8_t>(TDDE_SYNC_VAL_1));
+	const v128_t sync2 = wasm_i8x16_splat(static_cast<int8_t>(TDDE_SYNC_VAL_2));
+	const v128_t sync3 = wasm_i8x16_splat(static_cast<int8_t>(TDDE_SYNC_VAL_3));
+	const v128_t sync4 = wasm_i8x16_splat(static_cast<int8_t>(TDDE_SYNC_VAL_4));
+
+	for (; offset + 3 + 16 <= size; offset += 16)
+	{
+		const uint8_t* ptr = data + offset;
+		v128_t match = wasm_i8x16_eq(wasm_v128_load(ptr), sync1);
+		match = wasm_v128_and(match, wasm_i8x16_eq(wasm_v128_load(ptr + 1), sync2));
+		match = wasm_v128_and(match, wasm_i8x16_eq(wasm_v128_load(ptr + 2), sync3));
+		match = wasm_v128_and(match, wasm_i8x16_eq(wasm_v128_load(ptr + 3), sync4));
+
+		const uint32_t mask = static_cast<uint32_t>(wasm_i8x16_bitmask(match));
+		if (mask != 0)
+			return offset + LowestBitIndex(mask);
+	}
+#endif
+
+	// scalar tail (or the whole range without simd)
+	for (; offset + 4 <= size; ++offset)
+	{
+		u32 word;
+		memcpy(&word, data + offset, sizeof(u32));
+		if (word == TDDE_SYNC_VAL)
+			return offset;
+	}
+	return size;
+}
+
+/// <summary>
+/// check that a binary buffer is a sequence of aligned packets, each of them starts with a sync word
+/// </summary>
+inline bool HasAlignedSyncWords(const uint8_t* data, const size_t size)
+{
+	constexpr size_t packet_size = sizeof(CGIDataCartesian);
+	if (size == 0 || size % packet_size != 0)
+		return false;
+
+	for (size_t offset = 0; offset < size; offset += packet_size)
+	{
+		u32 word;
+		memcpy(&word, data + offset, sizeof(u32));
+		if (word != TDDE_SYNC_VAL)
+			return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// rebuild a list of packets from a damaged binary stream (dropped or inserted bytes)
+///  every sync word candidate is validated with a packet check sum, after a valid packet
+/// the scan continues right behind it, after a false candidate - from the next byte
+/// </summary>
+/// <returns>number of stream bytes which are not a part of any valid packet</returns>
+inline size_t ScanPackets(const uint8_t* data, const size_t size, std::vector<CGIDataCartesian>& packets)
+{
+	constexpr size_t packet_size = sizeof(CGIDataCartesian);
+	size_t skipped_bytes = 0;
+	size_t offset = 0;
+
+	CGIDataCartesian packet;
+	while (offset + packet_size <= size)
+	{
+		const size_t sync_offset = FindSyncWord(data, size, offset);
+		skipped_bytes += sync_offset - offset;
+		offset = sync_offset;
+
+		if (offset + packet_size > size)
+			break;
+
+		memcpy(&packet, data + offset, packet_size);
+		if (checkSum(&packet, CGI_DATA_LENGTH) == packet.checkSum)
+		{
+			packets.push_back(packet);
+			offset += packet_size;
+		}
+		else
+		{
+			skipped_bytes += 1;
+			offset += 1;
+		}
+	}
+	return skipped_bytes + (size - offset);
+}
+
+/// <summary>
+/// check sum of a packet as it's computed by checkSum(), but with a simd horizontal sum
+///  sum = words[2] + ... + words[14] - words[1]
+/// </summary>
+inline u32 PacketCheckSum(const CGIDataCartesian* packet)
+{
+	static_assert(sizeof(CGIDataCartesian) == 16 * sizeof(u32), "packet is expected to be 16 words long");
+
+#if defined(CGI_SIMD_AVX2) || defined(CGI_SIMD_SSE2)
+	const __m128i* words = reinterpret_cast<const __m128i*>(packet);
+	const __m128i mask_first = _mm_set_epi32(-1, -1, 0, 0);		// words 2, 3
+	const __m128i mask_number = _mm_set_epi32(0, 0, -1, 0);		// word 1 (packetNumber)
+	const __m128i mask_last = _mm_set_epi32(0, -1, -1, -1);		// words 12, 13, 14
+
+	const __m128i v0 = _mm_loadu_si128(words);
+	__m128i acc = _mm_add_epi32(_mm_loadu_si128(words + 1), _mm_loadu_si128(words + 2));
+	acc = _mm_add_epi32(acc, _mm_and_si128(_mm_loadu_si128(words + 3), mask_last));
+	acc = _mm_add_epi32(acc, _mm_and_si128(v0, mask_first));
+	acc = _mm_sub_epi32(acc, _mm_and_si128(v0, mask_number));
+
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	return static_cast<u32>(_mm_cvtsi128_si32(acc));
+#elif defined(CGI_SIMD_WASM)
+	const uint8_t* words = reinterpret_cast<const uint8_t*>(packet);
+	const v128_t mask_first = wasm_i32x4_make(0, 0, -1, -1);
+	const v128_t mask_number = wasm_i32x4_make(0, -1, 0, 0);
+	const v128_t mask_last = wasm_i32x4_make(-1, -1, -1, 0);
+
+	const v128_t v0 = wasm_v128_load(words);
+	v128_t acc = wasm_i32x4_add(wasm_v128_load(words + 16), wasm_v128_load(words + 32));
+	acc = wasm_i32x4_add(acc, wasm_v128_and(wasm_v128_load(words + 48), mask_last));
+	acc = wasm_i32x4_add(acc, wasm_v128_and(v0, mask_first));
+	acc = wasm_i32x4_sub(acc, wasm_v128_and(v0, mask_number));
+
+	acc = wasm_i32x4_add(acc, wasm_i32x4_shuffle(acc, acc, 2, 3, 0, 1));
+	acc = wasm_i32x4_add(acc, wasm_i32x4_shuffle(acc, acc, 1, 0, 3, 2));
+	return static_cast<u32>(wasm_i32x4_extract_lane(acc, 0));
+#else
+	u32 words[16];
+	memcpy(words, packet, sizeof(words));
+
+	u32 sum = 0u - words[1];
+	for (int i = 2; i < 15; ++i)
+		sum += words[i];
+	return sum;
+#endif
+}
+
+/// <summary>
+/// validate check sums of all packets in one pass
+///  the result is a bit mask with a bit per packet, bit is set for a packet with a wrong check sum
+/// </summary>
+/// <returns>number of packets with a wrong check sum</returns>
+inline size_t ValidatePacketCheckSums(const CGIDataCartesian* packets, const size_t count, std::vector<uint64_t>& bad_packets_mask)
+{
+	bad_packets_mask.assign((count + 63) / 64, 0);
+	size_t number_of_bad_packets = 0;
+
+	for (size_t block = 0; block < bad_packets_mask.size(); ++block)
+	{
+		const size_t first = block * 64;
+		const size_t last = std::min(first + 64, count);
+
+		uint64_t bits = 0;
+		for (size_t i = first; i < last; ++i)
+		{
+			const uint64_t is_bad = (PacketCheckSum(packets + i) != packets[i].checkSum) ? 1 : 0;
+			bits |= is_bad << (i - first);
+		}
+
+		bad_packets_mask[block] = bits;
+		if (bits != 0)
+		{
+			for (uint64_t b = bits; b != 0; b &= b - 1)
+				number_of_bad_packets += 1;
+		}
+	}
+	return number_of_bad_packets;
+}
+
+/// <summary>
+/// test a packet bit in a mask made by ValidatePacketCheckSums
+/// </summary>
+inline bool IsPacketMasked(const std::vector<uint64_t>& mask, const size_t index)
+{
+	return !mask.empty() && ((mask[index >> 6] >> (index & 63)) & 1) != 0;
+}
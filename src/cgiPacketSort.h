@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "cgidata.h"
+#include "parallelFor.h"
+
+/// <summary>
+/// how much out of order the packets were before sorting
+/// </summary>
+enum class PacketOrder : uint8_t
+{
+	Sorted,			//!< packets are in timecode order already, nothing to do
+	NearlySorted,	//!< a few runs of ordered packets, they are merged
+	Shuffled		//!< packets are radix sorted
+};
+
+struct PacketSortEntry
+{
+	uint64_t	key;	//!< timecode in upper bits, packet number in lower 32 bits
+	size_t		index;	//!< packet index in the input
+};
+
+/// <summary>
+/// sort key of a packet, packets with the same timecode are ordered by a packet number
+/// </summary>
+inline uint64_t PacketSortKey(const CGIDataCartesian& packet)
+{
+	return (static_cast<uint64_t>(TC2Int(packet.timeCode)) << 32) | static_cast<uint64_t>(packet.packetNumber);
+}
+
+/// <summary>
+/// stable LSD radix sort of entries by a key, 11 bits per pass
+///  passes where all keys have the same digit are skipped, histograms and scatter are computed in parallel
+/// </summary>
+inline void RadixSortPacketEntries(std::vector<PacketSortEntry>& entries)
+{
+	constexpr int digit_bits = 11;
+	constexpr size_t number_of_buckets = size_t(1) << digit_bits;
+	constexpr uint64_t digit_mask = number_of_buckets - 1;
+	constexpr size_t min_block_size = 1 << 16;
+
+	const size_t count = entries.size();
+	const size_t number_of_blocks = GetNumberOfParallelBlocks(count, min_block_size);
+
+	uint64_t all_bits = 0;
+	for (const PacketSortEntry& entry : entries)
+		all_bits |= entry.key;
+
+	std::vector<PacketSortEntry> temp(count);
+	std::vector<size_t> histograms(number_of_blocks * number_of_buckets);
+
+	for (int shift = 0; shift < 64; shift += digit_bits)
+	{
+		if ((all_bits >> shift) == 0)
+			break;
+
+		// per block histogram of the digit
+		std::fill(begin(histograms), end(histograms), 0);
+		ParallelFor(count, min_block_size, [&](const size_t first, const size_t last, const size_t block)
+			{
+				size_t* histogram = histograms.data() + block * number_of_buckets;
+				for (size_t i = first; i < last; ++i)
+					histogram[(entries[i].key >> shift) & digit_mask] += 1;
+			});
+
+		// skip the pass if all keys share the digit
+		bool is_single_bucket = false;
+		for (size_t bucket = 0; bucket < number_of_buckets; ++bucket)
+		{
+			size_t bucket_count = 0;
+			for (size_t block = 0; block < number_of_blocks; ++block)
+				bucket_count += histograms[block * number_of_buckets + bucket];
+
+			if (bucket_count == count)
+			{
+				is_single_bucket = true;
+				break;
+			}
+			else if (bucket_count > 0)
+			{
+				break;
+			}
+		}
+		if (is_single_bucket)
+			continue;
+
+		// exclusive prefix sum in the order bucket major, block minor to keep the sort stable
+		size_t offset = 0;
+		for (size_t bucket = 0; bucket < number_of_buckets; ++bucket)
+		{
+			for (size_t block = 0; block < number_of_blocks; ++block)
+			{
+				size_t& value = histograms[block * number_of_buckets + bucket];
+				const size_t bucket_count = value;
+				value = offset;
+				offset += bucket_count;
+			}
+		}
+
+		ParallelFor(count, min_block_size, [&](const size_t first, const size_t last, const size_t block)
+			{
+				size_t* offsets = histograms.data() + block * number_of_buckets;
+				for (size_t i = first; i < last; ++i)
+				{
+					const size_t bucket = static_cast<size_t>((entries[i].key >> shift) & digit_mask);
+					temp[offsets[bucket]++] = entries[i];
+				}
+			});
+
+		entries.swap(temp);
+	}
+}
+
+/// <summary>
+/// sort indices of packets by timecode (and packet number for packets of the same timecode)
+///  One linear pass detects already sorted input and counts ordered runs. A few runs are merged,
+/// otherwise the keys are radix sorted
+/// </summary>
+/// <returns>order of the input before sorting</returns>
+inline PacketOrder SortPacketIndices(const CGIDataCartesian* packets, std::vector<size_t>& indices)
+{
+	const size_t count = indices.size();
+	if (count < 2)
+		return PacketOrder::Sorted;
+
+	// run detection, a recording is almost always in order already
+	std::vector<size_t> run_starts(1, 0);
+	constexpr size_t max_merged_runs = 32;
+
+	uint64_t prev_key = PacketSortKey(packets[indices[0]]);
+	for (size_t i = 1; i < count && run_starts.size() <= max_merged_runs; ++i)
+	{
+		const uint64_t key = PacketSortKey(packets[indices[i]]);
+		if (key < prev_key)
+			run_starts.push_back(i);
+		prev_key = key;
+	}
+
+	if (run_starts.size() == 1)
+		return PacketOrder::Sorted;
+
+	std::vector<PacketSortEntry> entries(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		entries[i].key = PacketSortKey(packets[indices[i]]);
+		entries[i].index = indices[i];
+	}
+
+	PacketOrder order;
+	if (run_starts.size() <= max_merged_runs)
+	{
+		// bottom up merge of neighbour runs
+		auto fn_less = [](const PacketSortEntry& a, const PacketSortEntry& b) { return a.key < b.key; };
+
+		run_starts.push_back(count);
+		while (run_starts.size() > 2)
+		{
+			std::vector<size_t> merged_starts;
+			for (size_t i = 0; i + 1 < run_starts.size(); i += 2)
+			{
+				merged_starts.push_back(run_starts[i]);
+				if (i + 2 < run_starts.size())
+				{
+					std::inplace_merge(begin(entries) + run_starts[i], begin(entries) + run_starts[i + 1],
+						begin(entries) + run_starts[i + 2], fn_less);
+				}
+			}
+			merged_starts.push_back(count);
+			run_starts.swap(merged_starts);
+		}
+		order = PacketOrder::NearlySorted;
+	}
+	else
+	{
+		RadixSortPacketEntries(entries);
+		order = PacketOrder::Shuffled;
+	}
+
+	for (size_t i = 0; i < count; ++i)
+		indices[i] = entries[i].index;
+
+	return order;
+}
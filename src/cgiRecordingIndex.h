@@ -0,0 +1,257 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include "cgidata.h"
+#include "cgiPacketSort.h"
+#include "cgiStatistics.h"
+#include "miniz.h"
+
+/// <summary>
+/// Sidecar index of a binary recording (<recording>.cgiidx)
+///  It keeps results of the full passes over a recording - the sorted order of valid packets and
+/// the recording statistics, so a later trim of the same file reads only the packets of its trim ranges.
+///  The index is bound to the recording by the file size and a hash of sampled file blocks,
+/// and to the frame rate the statistics are computed for
+/// </summary>
+struct CGIRecordingIndex
+{
+	uint64_t		fileSize{ 0 };
+	uint32_t		fileHash{ 0 };
+	double			frameRate{ 0.0 };
+
+	/// number of packets in the file, including packets with a wrong check sum
+	uint64_t		numberOfPackets{ 0 };
+	PacketOrder		inputOrder{ PacketOrder::Sorted };
+
+	CGIStatistics	statistics;
+
+	/// indices of valid packets sorted by timecode
+	std::vector<uint32_t>	sortedPackets;
+};
+
+/// <summary>
+/// sidecar index file name, take.cgi gives take.cgiidx
+/// </summary>
+inline std::string GetRecordingIndexFilename(const std::string& recordingFilename)
+{
+	const size_t dot = recordingFilename.rfind('.');
+	const size_t separator = recordingFilename.find_last_of("/\\");
+	const bool hasExtension = dot != std::string::npos && (separator == std::string::npos || dot > separator);
+
+	return ((hasExtension) ? recordingFilename.substr(0, dot) : recordingFilename) + ".cgiidx";
+}
+
+/// <summary>
+/// cheap hash of a recording - crc32 of the size and of 64Kb blocks at the start, in the middle and at the end
+/// </summary>
+inline uint32_t ComputeRecordingHash(const uint8_t* buffer, const size_t size)
+{
+	constexpr size_t block_size = 64 * 1024;
+
+	const uint64_t size64 = static_cast<uint64_t>(size);
+	mz_ulong crc = mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(&size64), sizeof(uint64_t));
+
+	if (size <= 3 * block_size)
+		return static_cast<uint32_t>(mz_crc32(crc, buffer, size));
+
+	const size_t offsets[3] = { 0, (size - block_size) / 2, size - block_size };
+	for (const size_t offset : offsets)
+		crc = mz_crc32(crc, buffer + offset, block_size);
+
+	return static_cast<uint32_t>(crc);
+}
+
+/// <summary>
+/// check if the index is made for a given recording and a frame rate
+/// </summary>
+inline bool IsRecordingIndexValid(const CGIRecordingIndex& index, const uint8_t* buffer, const size_t size, const double frameRate)
+{
+	return index.fileSize == static_cast<uint64_t>(size)
+		&& index.frameRate == frameRate
+		&& index.fileHash == ComputeRecordingHash(buffer, size);
+}
+
+namespace CGIRecordingIndexFile
+{
+	constexpr char		MAGIC[8] = { 'C', 'G', 'I', 'I', 'D', 'X', 0, 0 };
+	constexpr uint32_t	VERSION = 2;
+
+	template<typename T>
+	void Write(std::string& data, const T& value)
+	{
+		data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	template<typename T>
+	bool Read(const std::string& data, size_t& pos, T& value)
+	{
+		if (pos + sizeof(T) > data.size())
+			return false;
+		memcpy(&value, data.data() + pos, sizeof(T));
+		pos += sizeof(T);
+		return true;
+	}
+}
+
+/// <summary>
+/// save the index into a binary file, the file content is protected by crc32
+/// </summary>
+inline bool WriteRecordingIndex(const char* filename, const CGIRecordingIndex& index)
+{
+	using namespace CGIRecordingIndexFile;
+
+	std::string data(MAGIC, sizeof(MAGIC));
+	Write(data, VERSION);
+	Write(data, index.fileSize);
+	Write(data, index.fileHash);
+	Write(data, index.frameRate);
+	Write(data, index.numberOfPackets);
+	Write(data, static_cast<uint32_t>(index.inputOrder));
+
+	const CGIStatistics& statistics = index.statistics;
+	Write(data, statistics.numberOfPackets);
+	Write(data, statistics.firstTimeCode);
+	Write(data, statistics.lastTimeCode);
+	Write(data, statistics.estimatedFrameRate);
+	Write(data, statistics.frameSteps);
+	Write(data, statistics.numberOfDuplicates);
+	Write(data, statistics.numberOfOutOfOrder);
+	Write(data, statistics.minDrift);
+	Write(data, statistics.maxDrift);
+	Write(data, statistics.lastDrift);
+	Write(data, statistics.numberOfGaps);
+	Write(data, statistics.gapsDuration);
+
+	Write(data, static_cast<uint64_t>(statistics.gaps.size()));
+	for (const CGIDataGap& gap : statistics.gaps)
+	{
+		Write(data, gap.packetIndex);
+		Write(data, gap.prevTimeCode);
+		Write(data, gap.timeCode);
+		Write(data, gap.duration);
+	}
+
+	Write(data, static_cast<uint64_t>(index.sortedPackets.size()));
+	data.append(reinterpret_cast<const char*>(index.sortedPackets.data()), index.sortedPackets.size() * sizeof(uint32_t));
+
+	const uint32_t crc = static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(data.data()), data.size()));
+	Write(data, crc);
+
+	// concurrent loads of a recording can write its index at the same time, every writer fills own
+	// temporary file and renames it into place, so a reader never sees a partially written index
+	static std::atomic<uint64_t> numberOfWrites(0);
+	const uint64_t stamp = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	const std::string tempFilename = std::string(filename) + "." + std::to_string(stamp) + "." + std::to_string(numberOfWrites++) + ".tmp";
+
+	{
+		std::ofstream file(tempFilename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return false;
+
+		file.write(data.data(), static_cast<std::streamsize>(data.size()));
+		if (!file.good())
+		{
+			file.close();
+			std::remove(tempFilename.c_str());
+			return false;
+		}
+	}
+
+	if (std::rename(tempFilename.c_str(), filename) != 0)
+	{
+		// rename doesn't replace an existing file on Windows
+		std::remove(filename);
+		if (std::rename(tempFilename.c_str(), filename) != 0)
+		{
+			std::remove(tempFilename.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// load the index from a file, returns false for a missing, damaged or an older version file
+/// </summary>
+inline bool ReadRecordingIndex(const char* filename, CGIRecordingIndex& index)
+{
+	using namespace CGIRecordingIndexFile;
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		return false;
+
+	const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (data.size() < sizeof(MAGIC) + sizeof(uint32_t) || memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+		return false;
+
+	const size_t contentSize = data.size() - sizeof(uint32_t);
+	uint32_t crc = 0;
+	memcpy(&crc, data.data() + contentSize, sizeof(uint32_t));
+	if (crc != static_cast<uint32_t>(mz_crc32(MZ_CRC32_INIT, reinterpret_cast<const unsigned char*>(data.data()), contentSize)))
+		return false;
+
+	size_t pos = sizeof(MAGIC);
+	uint32_t version = 0;
+	uint32_t inputOrder = 0;
+	uint64_t numberOfGaps = 0;
+	uint64_t numberOfSortedPackets = 0;
+	CGIStatistics& statistics = index.statistics;
+
+	bool status = Read(data, pos, version) && version == VERSION
+		&& Read(data, pos, index.fileSize)
+		&& Read(data, pos, index.fileHash)
+		&& Read(data, pos, index.frameRate)
+		&& Read(data, pos, index.numberOfPackets)
+		&& Read(data, pos, inputOrder)
+		&& Read(data, pos, statistics.numberOfPackets)
+		&& Read(data, pos, statistics.firstTimeCode)
+		&& Read(data, pos, statistics.lastTimeCode)
+		&& Read(data, pos, statistics.estimatedFrameRate)
+		&& Read(data, pos, statistics.frameSteps)
+		&& Read(data, pos, statistics.numberOfDuplicates)
+		&& Read(data, pos, statistics.numberOfOutOfOrder)
+		&& Read(data, pos, statistics.minDrift)
+		&& Read(data, pos, statistics.maxDrift)
+		&& Read(data, pos, statistics.lastDrift)
+		&& Read(data, pos, statistics.numberOfGaps)
+		&& Read(data, pos, statistics.gapsDuration)
+		&& Read(data, pos, numberOfGaps)
+		&& numberOfGaps <= CGIStatistics::MAX_GAPS;
+
+	index.inputOrder = static_cast<PacketOrder>(inputOrder);
+	statistics.gaps.resize(status ? static_cast<size_t>(numberOfGaps) : 0);
+	for (CGIDataGap& gap : statistics.gaps)
+	{
+		status = status
+			&& Read(data, pos, gap.packetIndex)
+			&& Read(data, pos, gap.prevTimeCode)
+			&& Read(data, pos, gap.timeCode)
+			&& Read(data, pos, gap.duration);
+	}
+
+	status = status && Read(data, pos, numberOfSortedPackets)
+		&& pos + numberOfSortedPackets * sizeof(uint32_t) == contentSize
+		&& numberOfSortedPackets <= index.numberOfPackets;
+
+	if (!status)
+		return false;
+
+	index.sortedPackets.resize(static_cast<size_t>(numberOfSortedPackets));
+	memcpy(index.sortedPackets.data(), data.data() + pos, index.sortedPackets.size() * sizeof(uint32_t));
+
+	// every index has to point to a packet of the recording
+	for (const uint32_t packetIndex : index.sortedPackets)
+	{
+		if (packetIndex >= index.numberOfPackets)
+			return false;
+	}
+	return true;
+}
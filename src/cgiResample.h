@@ -0,0 +1,242 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+#include "cgiPacketColumns.h"
+#include "cgiTimeCode.h"
+
+/// <summary>
+/// interpolation of channel values between packets
+/// </summary>
+enum class CGIResampleMethod : uint8_t
+{
+	Nearest,
+	Linear,
+	Cubic		//!< Catmull-Rom spline through 4 neighbour packets
+};
+
+/// <summary>
+/// Output key frame grid of an export, by default every packet becomes a key
+/// </summary>
+struct CGIResampling
+{
+	double				frameRate{ 0.0 };		//!< output frame rate, 0 - no resampling
+	CGIResampleMethod	method{ CGIResampleMethod::Linear };
+
+	bool IsEnabled() const { return frameRate > 0.0; }
+
+	/// <summary>
+	/// method from a name - nearest, linear or cubic
+	/// </summary>
+	static bool ParseMethod(const char* name, CGIResampleMethod& method)
+	{
+		if (strcmp(name, "nearest") == 0)
+			method = CGIResampleMethod::Nearest;
+		else if (strcmp(name, "linear") == 0)
+			method = CGIResampleMethod::Linear;
+		else if (strcmp(name, "cubic") == 0)
+			method = CGIResampleMethod::Cubic;
+		else
+			return false;
+		return true;
+	}
+};
+
+/// <summary>
+/// Weights of source packets for every output key, the same for all channels
+///  The kernel is computed once for a key grid, then every channel is a loop of a fixed number of taps,
+/// the source values are gathered by the tap indices (the taps of a key are clamped at the packets range edges)
+/// </summary>
+struct CGIResampleKernel
+{
+	static constexpr size_t MAX_TAPS = 4;
+
+	size_t					numberOfTaps{ 1 };
+	std::vector<uint32_t>	indices;		//!< numberOfTaps source indices per output key
+	std::vector<float>		weights;		//!< numberOfTaps weights per output key
+	std::vector<uint32_t>	nearest;		//!< the nearest source index per output key, for discrete channels
+
+	size_t Count() const { return nearest.size(); }
+
+	/// <summary>
+	/// output[k] = sum of weights * source values of the key taps
+	/// </summary>
+	void Apply(const float* source, float* output) const
+	{
+		switch (numberOfTaps)
+		{
+		case 1: ApplyTaps<1>(source, output); break;
+		case 2: ApplyTaps<2>(source, output); break;
+		default: ApplyTaps<MAX_TAPS>(source, output); break;
+		}
+	}
+
+private:
+
+	template<size_t TAPS>
+	void ApplyTaps(const float* source, float* output) const
+	{
+		const size_t count = Count();
+		const uint32_t* tap_indices = indices.data();
+		const float* tap_weights = weights.data();
+
+		for (size_t k = 0; k < count; ++k)
+		{
+			float value = 0.0f;
+			for (size_t t = 0; t < TAPS; ++t)
+				value += tap_weights[k * TAPS + t] * source[tap_indices[k * TAPS + t]];
+			output[k] = value;
+		}
+	}
+};
+
+/// <summary>
+/// sample times of sorted packets [first; last) in fbx time
+///  packets of a high rate recording share a timecode frame, they are spread evenly within the frame
+/// </summary>
+inline void ComputeSampleTimes(const CGIPacketColumns& columns, const size_t first, const size_t last, std::vector<fbx::i64>& times)
+{
+	times.resize(last - first);
+
+	size_t run_first = first;
+	while (run_first < last)
+	{
+		size_t run_last = run_first + 1;
+		while (run_last < last && columns.frameIndex[run_last] == columns.frameIndex[run_first])
+			++run_last;
+
+		const fbx::i64 frame_time = columns.keyTime[run_first];
+		const fbx::i64 frame_duration = FrameCountToKeyTime(columns.frameIndex[run_first] + 1, columns.timeCodeRate) - frame_time;
+		const fbx::i64 run_length = static_cast<fbx::i64>(run_last - run_first);
+
+		for (size_t i = run_first; i < run_last; ++i)
+			times[i - first] = frame_time + frame_duration * static_cast<fbx::i64>(i - run_first) / run_length;
+
+		run_first = run_last;
+	}
+}
+
+/// <summary>
+/// kernel of an output frame grid over sorted packets [first; last)
+///  output keys are on whole frames of the output frame rate within the packets time span,
+/// frames inside a data gap (packets more than a second apart) get no key
+/// </summary>
+/// <param name="keyTimes">output key times</param>
+inline void ComputeResampleKernel(const CGIPacketColumns& columns, const size_t first, const size_t last, const CGIResampling& resampling,
+	std::vector<fbx::i64>& keyTimes, CGIResampleKernel& kernel)
+{
+	keyTimes.clear();
+	kernel.indices.clear();
+	kernel.weights.clear();
+	kernel.nearest.clear();
+	kernel.numberOfTaps = (resampling.method == CGIResampleMethod::Nearest) ? 1 : (resampling.method == CGIResampleMethod::Linear) ? 2 : 4;
+
+	if (first >= last)
+		return;
+
+	std::vector<fbx::i64> times;
+	ComputeSampleTimes(columns, first, last, times);
+
+	const CGIFrameRate rate = CGIFrameRate::FromDouble(resampling.frameRate);
+	const fbx::i64 max_interval = FBX_SECOND_TICKS;
+
+	// the first output frame at or after the first sample, the estimate is corrected with the exact conversion
+	int64_t frame = static_cast<int64_t>(std::floor(KeyTimeToSeconds(times.front()) * rate.ToDouble()));
+	while (frame > 0 && FrameCountToKeyTime(frame, rate) >= times.front())
+		--frame;
+	while (FrameCountToKeyTime(frame, rate) < times.front())
+		++frame;
+
+	const int64_t last_sample = static_cast<int64_t>(times.size()) - 1;
+	int64_t j = 0;	// sample interval [j; j + 1] of the key time
+
+	for (fbx::i64 keyTime = FrameCountToKeyTime(frame, rate); keyTime <= times.back(); keyTime = FrameCountToKeyTime(++frame, rate))
+	{
+		while (j < last_sample && times[j + 1] <= keyTime)
+			++j;
+
+		const int64_t j1 = std::min(j + 1, last_sample);
+		if (times[j1] - times[j] > max_interval)
+			continue;
+
+		const double interval = static_cast<double>(times[j1] - times[j]);
+		const float u = (interval > 0.0) ? static_cast<float>(static_cast<double>(keyTime - times[j]) / interval) : 0.0f;
+
+		keyTimes.push_back(keyTime);
+		kernel.nearest.push_back(static_cast<uint32_t>(first + ((u < 0.5f) ? j : j1)));
+
+		switch (resampling.method)
+		{
+		case CGIResampleMethod::Nearest:
+			kernel.indices.push_back(kernel.nearest.back());
+			kernel.weights.push_back(1.0f);
+			break;
+
+		case CGIResampleMethod::Linear:
+			kernel.indices.push_back(static_cast<uint32_t>(first + j));
+			kernel.indices.push_back(static_cast<uint32_t>(first + j1));
+			kernel.weights.push_back(1.0f - u);
+			kernel.weights.push_back(u);
+			break;
+
+		case CGIResampleMethod::Cubic:
+		{
+			const int64_t j0 = std::max(j - 1, int64_t(0));
+			const int64_t j2 = std::min(j1 + 1, last_sample);
+			const float u2 = u * u;
+			const float u3 = u2 * u;
+
+			kernel.indices.push_back(static_cast<uint32_t>(first + j0));
+			kernel.indices.push_back(static_cast<uint32_t>(first + j));
+			kernel.indices.push_back(static_cast<uint32_t>(first + j1));
+			kernel.indices.push_back(static_cast<uint32_t>(first + j2));
+			kernel.weights.push_back(0.5f * (-u3 + 2.0f * u2 - u));
+			kernel.weights.push_back(0.5f * (3.0f * u3 - 5.0f * u2 + 2.0f));
+			kernel.weights.push_back(0.5f * (-3.0f * u3 + 4.0f * u2 + u));
+			kernel.weights.push_back(0.5f * (u3 - u2));
+		} break;
+		}
+	}
+}
+
+/// <summary>
+/// resample all channels of sorted packets [first; last) onto an output frame grid
+///  continuous channels are interpolated, packet numbers and timecodes are taken from the nearest packet
+/// </summary>
+/// <returns>number of output keys</returns>
+inline size_t ResampleColumns(const CGIPacketColumns& columns, const size_t first, const size_t last, const CGIResampling& resampling,
+	CGIPacketColumns& output)
+{
+	std::vector<fbx::i64> keyTimes;
+	CGIResampleKernel kernel;
+	ComputeResampleKernel(columns, first, last, resampling, keyTimes, kernel);
+
+	const size_t count = kernel.Count();
+	output.frameRate = columns.frameRate;
+	output.nominalFrameRate = columns.nominalFrameRate;
+	output.timeCodeRate = columns.timeCodeRate;
+	output.Resize(count);
+
+	std::vector<float> CGIPacketColumns::* const channels[] = {
+		&CGIPacketColumns::x, &CGIPacketColumns::y, &CGIPacketColumns::z,
+		&CGIPacketColumns::pan, &CGIPacketColumns::tilt, &CGIPacketColumns::roll,
+		&CGIPacketColumns::zoom, &CGIPacketColumns::focus, &CGIPacketColumns::iris,
+		&CGIPacketColumns::trackPos };
+
+	for (const auto channel : channels)
+		kernel.Apply((columns.*channel).data(), (output.*channel).data());
+
+	for (size_t k = 0; k < count; ++k)
+	{
+		const uint32_t nearest = kernel.nearest[k];
+		output.packetNumber[k] = columns.packetNumber[nearest];
+		output.timeCode[k] = columns.timeCode[nearest];
+		output.frameIndex[k] = columns.frameIndex[nearest];
+	}
+	output.keyTime.assign(begin(keyTimes), end(keyTimes));
+
+	return count;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "cgiConvert.h"
+#include "cgiStatistics.h"
+
+/// <summary>
+/// A loaded recording which is queried and trimmed many times
+///  Packets are loaded, validated and sorted once, derived columns are built once for the session frame rate.
+/// The session keeps its own copy of the input, so the caller can free the buffer right after the open
+/// </summary>
+class CGISession
+{
+public:
+
+	/// <summary>
+	/// load packets from a buffer, returns false if the buffer has no packets
+	/// </summary>
+	bool Open(const uint8_t* buffer, size_t size, const double frame_rate)
+	{
+		Close();
+
+		m_FrameRate = frame_rate;
+		m_Buffer.assign(buffer, buffer + size);
+
+		if (!m_Convert.LoadPackets(m_Buffer.data(), m_Buffer.size(), static_cast<float>(frame_rate))
+			|| m_Convert.IsEmpty())
+		{
+			Close();
+			return false;
+		}
+
+		// packets are unpacked into own memory (ascii, damaged or shuffled stream), the input is not needed any more
+		if (!m_Convert.IsViewingInput())
+		{
+			std::vector<uint8_t> empty_buffer;
+			m_Buffer.swap(empty_buffer);
+		}
+
+		m_Convert.BuildColumns(frame_rate);
+		ComputeStatistics(m_Convert.GetColumns(), m_Statistics);
+		m_StatisticsJSON = ::GetStatisticsJSON(m_Statistics, frame_rate);
+		return true;
+	}
+
+	void Close()
+	{
+		m_Convert = CGIConvert();
+		m_Statistics = CGIStatistics();
+		m_StatisticsJSON.clear();
+		std::vector<uint8_t> empty_buffer;
+		m_Buffer.swap(empty_buffer);
+	}
+
+	bool IsOpen() const { return !m_Convert.IsEmpty(); }
+
+	double GetFrameRate() const { return m_FrameRate; }
+
+	CGIConvert& GetConvert() { return m_Convert; }
+	const CGIConvert& GetConvert() const { return m_Convert; }
+
+	/// <summary>
+	/// statistics of the loaded packets, computed once on open
+	/// </summary>
+	const CGIStatistics& GetStatistics() const { return m_Statistics; }
+	const std::string& GetStatisticsJSON() const { return m_StatisticsJSON; }
+
+private:
+
+	double					m_FrameRate{ 25.0 };
+
+	/// a copy of the input when packets are viewed in place
+	std::vector<uint8_t>	m_Buffer;
+	CGIConvert				m_Convert;
+
+	CGIStatistics			m_Statistics;
+	std::string				m_StatisticsJSON;
+};
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <array>
+#include <algorithm>
+#include <cstdio>
+#include <stdint.h>
+#include "cgidata.h"
+#include "cgiPacketColumns.h"
+
+/// <summary>
+/// a time span without packets between two neighbour sorted packets
+/// </summary>
+struct CGIDataGap
+{
+	uint32_t		packetIndex{ 0 };		//!< sorted index of the packet after the gap
+	timeCodeStruct	prevTimeCode{};
+	timeCodeStruct	timeCode{};
+	float			duration{ 0.0f };		//!< [seconds]
+};
+
+/// <summary>
+/// Statistics of sorted packets of a recording, see CGIStatisticsPass
+/// </summary>
+struct CGIStatistics
+{
+	/// the frame step histogram has a bin per step 0 .. MAX_FRAME_STEP - 1 and the last bin for longer steps
+	static constexpr size_t MAX_FRAME_STEP = 8;
+	/// number of the longest gaps kept
+	static constexpr size_t MAX_GAPS = 6;
+
+	uint64_t		numberOfPackets{ 0 };
+
+	timeCodeStruct	firstTimeCode{};
+	timeCodeStruct	lastTimeCode{};
+
+	/// number of frames per timecode second the packets use most often
+	int32_t			estimatedFrameRate{ 0 };
+
+	/// jitter, number of neighbour packets per a frame step between their timecodes
+	std::array<uint64_t, MAX_FRAME_STEP + 1>	frameSteps;
+
+	/// packets with the same timecode as the previous packet
+	uint64_t		numberOfDuplicates{ 0 };
+	/// packets with a packet number lower than the previous packet in the timecode order
+	uint64_t		numberOfOutOfOrder{ 0 };
+
+	/// drift of packet numbers against timecodes - packet number advance minus frame advance since the first packet
+	int64_t			minDrift{ 0 };
+	int64_t			maxDrift{ 0 };
+	int64_t			lastDrift{ 0 };
+
+	/// all gaps longer than a second
+	uint64_t		numberOfGaps{ 0 };
+	double			gapsDuration{ 0.0 };		//!< [seconds]
+
+	/// up to MAX_GAPS longest gaps, the longest first
+	std::vector<CGIDataGap>	gaps;
+
+	CGIStatistics()
+	{
+		frameSteps.fill(0);
+	}
+};
+
+/// <summary>
+/// Single pass statistics over packets in the timecode order
+///  Every packet is added once and the pass keeps only a constant state - counters, the previous packet
+/// and a min heap of the longest gaps, so the pass can follow a load or a live stream
+/// </summary>
+class CGIStatisticsPass
+{
+public:
+
+	CGIStatisticsPass()
+	{
+		m_FrameRateVotes.fill(0);
+	}
+
+	/// <summary>
+	/// add the next sorted packet
+	/// </summary>
+	/// <param name="frameIndex">timecode as a number of frames, see TimeCodeToFrameCount</param>
+	/// <param name="keyTime">timecode as fbx time, see FrameCountToKeyTime</param>
+	void Add(const timeCodeStruct& timeCode, const int64_t frameIndex, const fbx::i64 keyTime, const u32 packetNumber)
+	{
+		constexpr double time_thres{ 1.0 };
+
+		const double currTime = KeyTimeToSeconds(keyTime);
+
+		if (m_Statistics.numberOfPackets == 0)
+		{
+			m_Statistics.firstTimeCode = timeCode;
+			m_FirstFrameIndex = frameIndex;
+			m_FirstPacketNumber = packetNumber;
+		}
+		else
+		{
+			const double timeStep = currTime - m_PrevTime;
+
+			// a frame counter wraps to the next second, the previous frame tells the frame rate
+			if (timeStep < time_thres && m_PrevTimeCode.frames > timeCode.frames)
+			{
+				m_FrameRateVotes[m_PrevTimeCode.frames + 1] += 1;
+			}
+
+			if (timeStep > time_thres)
+			{
+				CGIDataGap gap;
+				gap.packetIndex = static_cast<uint32_t>(m_Statistics.numberOfPackets);
+				gap.prevTimeCode = m_PrevTimeCode;
+				gap.timeCode = timeCode;
+				gap.duration = static_cast<float>(timeStep);
+				AddGap(gap);
+			}
+
+			const int64_t frameStep = frameIndex - m_PrevFrameIndex;
+			m_Statistics.frameSteps[static_cast<size_t>(std::min(std::max(frameStep, int64_t(0)), static_cast<int64_t>(CGIStatistics::MAX_FRAME_STEP)))] += 1;
+
+			if (frameStep == 0)
+				m_Statistics.numberOfDuplicates += 1;
+			if (packetNumber < m_PrevPacketNumber)
+				m_Statistics.numberOfOutOfOrder += 1;
+		}
+
+		// packet numbers are unsigned and may wrap around
+		const int64_t drift = static_cast<int64_t>(static_cast<u32>(packetNumber - m_FirstPacketNumber)) - (frameIndex - m_FirstFrameIndex);
+		m_Statistics.minDrift = (m_Statistics.numberOfPackets == 0) ? drift : std::min(m_Statistics.minDrift, drift);
+		m_Statistics.maxDrift = (m_Statistics.numberOfPackets == 0) ? drift : std::max(m_Statistics.maxDrift, drift);
+		m_Statistics.lastDrift = drift;
+
+		m_Statistics.lastTimeCode = timeCode;
+		m_Statistics.numberOfPackets += 1;
+
+		m_PrevTimeCode = timeCode;
+		m_PrevTime = currTime;
+		m_PrevFrameIndex = frameIndex;
+		m_PrevPacketNumber = packetNumber;
+	}
+
+	/// <summary>
+	/// complete the pass, the pass can't be continued after that
+	/// </summary>
+	void Finish(CGIStatistics& statistics)
+	{
+		uint64_t frameRatePackets = 0;
+		for (size_t rate = 0; rate < m_FrameRateVotes.size(); ++rate)
+		{
+			if (m_FrameRateVotes[rate] > frameRatePackets)
+			{
+				m_Statistics.estimatedFrameRate = static_cast<int32_t>(rate);
+				frameRatePackets = m_FrameRateVotes[rate];
+			}
+		}
+
+		std::sort_heap(begin(m_Statistics.gaps), end(m_Statistics.gaps), IsLongerGap);
+		statistics = std::move(m_Statistics);
+	}
+
+private:
+
+	CGIStatistics	m_Statistics;
+
+	/// number of frame counter wraps per a last frame + 1, the frame counter has 5 bits
+	std::array<uint64_t, 33>	m_FrameRateVotes;
+
+	timeCodeStruct	m_PrevTimeCode{};
+	double			m_PrevTime{ 0.0 };
+	int64_t			m_PrevFrameIndex{ 0 };
+	u32				m_PrevPacketNumber{ 0 };
+
+	int64_t			m_FirstFrameIndex{ 0 };
+	u32				m_FirstPacketNumber{ 0 };
+
+	/// gaps order, the longest first and an earlier one first for the same duration
+	static bool IsLongerGap(const CGIDataGap& a, const CGIDataGap& b)
+	{
+		return (a.duration != b.duration) ? a.duration > b.duration : a.packetIndex < b.packetIndex;
+	}
+
+	void AddGap(const CGIDataGap& gap)
+	{
+		m_Statistics.numberOfGaps += 1;
+		m_Statistics.gapsDuration += static_cast<double>(gap.duration);
+
+		// heap top is the shortest of the kept gaps
+		std::vector<CGIDataGap>& gaps = m_Statistics.gaps;
+		if (gaps.size() < CGIStatistics::MAX_GAPS)
+		{
+			gaps.push_back(gap);
+			std::push_heap(begin(gaps), end(gaps), IsLongerGap);
+		}
+		else if (IsLongerGap(gap, gaps.front()))
+		{
+			std::pop_heap(begin(gaps), end(gaps), IsLongerGap);
+			gaps.back() = gap;
+			std::push_heap(begin(gaps), end(gaps), IsLongerGap);
+		}
+	}
+};
+
+/// <summary>
+/// compute statistics of sorted packets columns
+/// </summary>
+inline void ComputeStatistics(const CGIPacketColumns& columns, CGIStatistics& statistics)
+{
+	CGIStatisticsPass pass;
+	for (size_t i = 0; i < columns.Count(); ++i)
+	{
+		pass.Add(columns.timeCode[i], columns.frameIndex[i], columns.keyTime[i], columns.packetNumber[i]);
+	}
+	pass.Finish(statistics);
+}
+
+/// <summary>
+/// statistics as a json object, timecodes are "hh:mm:ss:ff" strings
+/// </summary>
+inline std::string GetStatisticsJSON(const CGIStatistics& statistics, const double frameRate)
+{
+	auto fn_timeCode = [](const timeCodeStruct& timeCode) -> std::string
+		{
+			char temp[32]{ 0 };
+			snprintf(temp, sizeof(temp), "\"%02u:%02u:%02u:%02u\"", timeCode.hours, timeCode.minutes, timeCode.seconds, timeCode.frames);
+			return temp;
+		};
+
+	char temp[256]{ 0 };
+	std::string json("{\n");
+
+	snprintf(temp, sizeof(temp), "  \"numberOfPackets\": %llu,\n  \"frameRate\": %g,\n  \"estimatedFrameRate\": %d,\n",
+		static_cast<unsigned long long>(statistics.numberOfPackets), frameRate, statistics.estimatedFrameRate);
+	json += temp;
+
+	if (statistics.numberOfPackets > 0)
+	{
+		json += "  \"firstTimeCode\": " + fn_timeCode(statistics.firstTimeCode) + ",\n";
+		json += "  \"lastTimeCode\": " + fn_timeCode(statistics.lastTimeCode) + ",\n";
+	}
+
+	json += "  \"frameSteps\": [";
+	for (size_t i = 0; i < statistics.frameSteps.size(); ++i)
+	{
+		snprintf(temp, sizeof(temp), (i > 0) ? ", %llu" : "%llu", static_cast<unsigned long long>(statistics.frameSteps[i]));
+		json += temp;
+	}
+	json += "],\n";
+
+	snprintf(temp, sizeof(temp), "  \"duplicates\": %llu,\n  \"outOfOrder\": %llu,\n  \"drift\": { \"min\": %lld, \"max\": %lld, \"last\": %lld },\n",
+		static_cast<unsigned long long>(statistics.numberOfDuplicates), static_cast<unsigned long long>(statistics.numberOfOutOfOrder),
+		static_cast<long long>(statistics.minDrift), static_cast<long long>(statistics.maxDrift), static_cast<long long>(statistics.lastDrift));
+	json += temp;
+
+	snprintf(temp, sizeof(temp), "  \"numberOfGaps\": %llu,\n  \"gapsDuration\": %.3f,\n  \"gaps\": [",
+		static_cast<unsigned long long>(statistics.numberOfGaps), statistics.gapsDuration);
+	json += temp;
+
+	for (size_t i = 0; i < statistics.gaps.size(); ++i)
+	{
+		const CGIDataGap& gap = statistics.gaps[i];
+		snprintf(temp, sizeof(temp), "%s\n    { \"packetIndex\": %u, \"from\": %s, \"to\": %s, \"duration\": %.3f }", (i > 0) ? "," : "",
+			gap.packetIndex, fn_timeCode(gap.prevTimeCode).c_str(), fn_timeCode(gap.timeCode).c_str(), static_cast<double>(gap.duration));
+		json += temp;
+	}
+	json += (statistics.gaps.empty()) ? "]\n}\n" : "\n  ]\n}\n";
+	return json;
+}
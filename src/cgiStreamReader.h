@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <stdio.h>
+#include "cgidata.h"
+#include "cgiPacketDecoder.h"
+#include "cgiAsciiParser.h"
+#include "cgiLog.h"
+
+/// <summary>
+/// Incremental reader of a raw cgi stream (binary or ascii)
+///  The stream is fed by chunks of any size, a partial packet (or a partial text line) at the end of
+/// a chunk is carried over and completed by the next chunk. Every decoded packet is passed to a callback
+/// right away, so the reader itself holds no more than one chunk of the stream
+///  Binary packets are framed by the sync word and validated by the check sum
+/// </summary>
+class CGIStreamReader
+{
+public:
+
+	typedef std::function<void(const CGIDataCartesian&)>	PacketCallback;
+
+	CGIStreamReader(const float frame_rate, PacketCallback callback)
+		: m_FrameRate(frame_rate)
+		, m_Callback(callback)
+	{}
+
+	/// <summary>
+	/// process next chunk of the stream, returns false on a parse error
+	///  format of the stream is detected by the first chunk
+	/// </summary>
+	bool Feed(const uint8_t* data, size_t size)
+	{
+		if (m_HasError)
+			return false;
+		if (size == 0)
+			return true;
+
+		if (m_Format == Format::Unknown)
+		{
+			// the same decision as a whole buffer load, see CGIConvert::IsAscii
+			m_Format = (IsAsciiData(data, size)) ? Format::Ascii : Format::Binary;
+		}
+
+		return (m_Format == Format::Ascii) ? FeedAscii(data, size) : FeedBinary(data, size);
+	}
+
+	/// <summary>
+	/// flush the tail of the stream, returns false if the last ascii line can't be parsed
+	/// </summary>
+	bool Finish()
+	{
+		if (m_HasError)
+			return false;
+
+		if (m_Format == Format::Ascii && !m_PendingLine.empty())
+		{
+			const bool status = ParseLine(m_PendingLine.data(), m_PendingLine.data() + m_PendingLine.size());
+			m_PendingLine.clear();
+			return status;
+		}
+		else if (m_Format == Format::Binary)
+		{
+			if (m_Decoder.GetNumberOfCheckSumErrors() > 0)
+				LogPrintf("Damaged stream, %zu packets with a wrong check sum\n", m_Decoder.GetNumberOfCheckSumErrors());
+			if (m_Decoder.HasPendingData())
+				LogPrintf("Stream ends with a partial packet\n");
+			m_Decoder.Reset();
+		}
+		return true;
+	}
+
+	bool HasError() const { return m_HasError; }
+
+	/// <summary>
+	/// number of packets decoded so far
+	/// </summary>
+	size_t GetNumberOfPackets() const { return m_NumberOfPackets; }
+
+private:
+
+	enum class Format : uint8_t
+	{
+		Unknown,
+		Binary,
+		Ascii
+	};
+
+	Format				m_Format{ Format::Unknown };
+	float				m_FrameRate{ 25.0f };
+	PacketCallback		m_Callback;
+	bool				m_HasError{ false };
+	size_t				m_NumberOfPackets{ 0 };
+
+	// binary framing, carries a partial packet over
+	CGIPacketDecoder	m_Decoder;
+	std::vector<CGIDataCartesian>	m_DecodedPackets;
+
+	// ascii carry over
+	std::string			m_PendingLine;
+
+	void EmitPacket(const CGIDataCartesian& packet)
+	{
+		m_NumberOfPackets += 1;
+		if (m_Callback)
+			m_Callback(packet);
+	}
+
+	bool FeedBinary(const uint8_t* data, size_t size)
+	{
+		m_DecodedPackets.clear();
+		m_Decoder.Feed(data, size, m_DecodedPackets);
+
+		for (const CGIDataCartesian& packet : m_DecodedPackets)
+			EmitPacket(packet);
+		return true;
+	}
+
+	bool FeedAscii(const uint8_t* data, size_t size)
+	{
+		const char* text = reinterpret_cast<const char*>(data);
+		const char* text_end = text + size;
+
+		while (text < text_end)
+		{
+			const char* line_end = static_cast<const char*>(memchr(text, '\n', text_end - text));
+			if (line_end == nullptr)
+			{
+				m_PendingLine.append(text, text_end);
+				break;
+			}
+
+			bool status;
+			if (m_PendingLine.empty())
+			{
+				status = ParseLine(text, line_end);
+			}
+			else
+			{
+				m_PendingLine.append(text, line_end);
+				status = ParseLine(m_PendingLine.data(), m_PendingLine.data() + m_PendingLine.size());
+				m_PendingLine.clear();
+			}
+
+			if (!status)
+				return false;
+			text = line_end + 1;
+		}
+		return true;
+	}
+
+	bool ParseLine(const char* line, const char* line_end)
+	{
+		CGIDataCartesian packet;
+		if (!ParseAsciiLine(line, line_end, static_cast<int>(m_NumberOfPackets), m_FrameRate, packet))
+		{
+			LogPrintf("loadCGI ERROR: Parse error for line ...\n");
+			m_HasError = true;
+			return false;
+		}
+		EmitPacket(packet);
+		return true;
+	}
+};
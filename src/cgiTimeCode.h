@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include "cgidata.h"
+#include "fbxtypes.h"
+
+/// fbx time units in a second, the same value OFBTime uses
+constexpr fbx::i64 FBX_SECOND_TICKS = 46186158000LL;
+
+/// <summary>
+/// Rational frame rate of timecodes, 29.97 is 30000 / 1001
+/// </summary>
+struct CGIFrameRate
+{
+	int64_t		numerator{ 25 };
+	int64_t		denominator{ 1 };
+
+	/// number of frames in a timecode second, 30 for 29.97
+	int32_t		nominal{ 25 };
+
+	/// <summary>
+	/// a rate from a user defined value, 23.976, 29.97, 47.952, 59.94 and 119.88 are recognized as NTSC rates
+	/// </summary>
+	static CGIFrameRate FromDouble(const double fps)
+	{
+		CGIFrameRate rate;
+		rate.nominal = std::max(1, static_cast<int32_t>(std::lround(fps)));
+
+		if (std::abs(fps - static_cast<double>(rate.nominal)) < 0.000001)
+		{
+			rate.numerator = rate.nominal;
+			rate.denominator = 1;
+		}
+		else if (std::abs(fps - 1000.0 * rate.nominal / 1001.0) < 0.005)
+		{
+			rate.numerator = 1000 * static_cast<int64_t>(rate.nominal);
+			rate.denominator = 1001;
+		}
+		else
+		{
+			rate.numerator = std::max(static_cast<int64_t>(1), static_cast<int64_t>(std::llround(fps * 1000.0)));
+			rate.denominator = 1000;
+
+			int64_t a = rate.numerator, b = rate.denominator;
+			while (b != 0)
+			{
+				const int64_t r = a % b;
+				a = b;
+				b = r;
+			}
+			rate.numerator /= a;
+			rate.denominator /= a;
+		}
+		return rate;
+	}
+
+	double ToDouble() const { return static_cast<double>(numerator) / static_cast<double>(denominator); }
+
+	/// <summary>
+	/// SMPTE drop frame applies to NTSC rates with a multiple of 30 nominal frames
+	/// </summary>
+	bool HasDropFrame() const { return denominator == 1001 && nominal % 30 == 0; }
+};
+
+/// <summary>
+/// number of frames since midnight of a timecode
+///  frame numbers above the nominal rate count as the next second, a drop frame timecode skips
+/// the first 2 frame numbers (4 for 59.94) of every minute except every tenth minute
+/// </summary>
+inline int64_t TimeCodeToFrameCount(const timeCodeStruct& timeCode, const CGIFrameRate& rate)
+{
+	const int64_t minutes = 60 * static_cast<int64_t>(timeCode.hours) + static_cast<int64_t>(timeCode.minutes);
+	const int64_t seconds = 60 * minutes + static_cast<int64_t>(timeCode.seconds);
+
+	int64_t frames = seconds * rate.nominal + std::min(static_cast<int32_t>(timeCode.frames), rate.nominal);
+
+	if (timeCode.dropFrame && rate.HasDropFrame())
+	{
+		const int64_t dropped_per_minute = rate.nominal / 15;
+		frames -= dropped_per_minute * (minutes - minutes / 10);
+	}
+	return frames;
+}
+
+/// <summary>
+/// fbx time of a frame, computed with integers only, the result is truncated to a whole time unit
+/// </summary>
+inline fbx::i64 FrameCountToKeyTime(const int64_t frames, const CGIFrameRate& rate)
+{
+	// split the frames by the numerator to keep the product in 64 bits
+	const int64_t seconds_part = frames / rate.numerator;
+	const int64_t frames_part = frames % rate.numerator;
+
+	return seconds_part * rate.denominator * FBX_SECOND_TICKS + (frames_part * rate.denominator * FBX_SECOND_TICKS) / rate.numerator;
+}
+
+inline fbx::i64 TimeCodeToKeyTime(const timeCodeStruct& timeCode, const CGIFrameRate& rate)
+{
+	return FrameCountToKeyTime(TimeCodeToFrameCount(timeCode, rate), rate);
+}
+
+inline double KeyTimeToSeconds(const fbx::i64 keyTime)
+{
+	return static_cast<double>(keyTime) / static_cast<double>(FBX_SECOND_TICKS);
+}
+
+/// <summary>
+/// frame count of a timecode label time, trim times are label seconds hh * 3600 + mm * 60 + ss (+ ff / nominal rate)
+///  like the timecodes printed for a recording, at NTSC rates a label second is 1.001 s of real time.
+///  A start bound is the first frame at or after the label, an end bound is the last frame at or before it,
+/// a drop frame label of a skipped frame number moves to the next or the previous existing frame
+/// </summary>
+inline int64_t LabelSecondsToFrameCount(const double seconds, const CGIFrameRate& rate, const bool dropFrame, const bool isEndBound)
+{
+	const int64_t nominal = static_cast<int64_t>(rate.nominal);
+	const double label_frames = seconds * static_cast<double>(nominal);
+
+	// a tolerance for a label given as a fraction of a second
+	int64_t label = static_cast<int64_t>((isEndBound) ? std::floor(label_frames + 0.000001) : std::ceil(label_frames - 0.000001));
+	label = std::max(label, static_cast<int64_t>(0));
+
+	const int64_t label_seconds = label / nominal;
+	int64_t frame = label % nominal;
+	int64_t frames = label;
+
+	if (dropFrame && rate.HasDropFrame())
+	{
+		const int64_t minutes = label_seconds / 60;
+		const int64_t dropped_per_minute = nominal / 15;
+		const bool is_skipped = (label_seconds % 60 == 0) && (minutes % 10 != 0) && frame < dropped_per_minute;
+
+		if (is_skipped)
+			frame = dropped_per_minute;
+
+		frames = label_seconds * nominal + frame - dropped_per_minute * (minutes - minutes / 10);
+		if (is_skipped && isEndBound)
+			frames -= 1;
+	}
+	return frames;
+}
@@ -31,19 +31,12 @@ u32 checkSum(const void *data, unsigned int size){
 	return(sum);
 }
 
-#define SM_WAIT_1 (0)
-#define SM_WAIT_2 (1)
-#define SM_WAIT_3 (2)
-#define SM_WAIT_4 (3)
-#define SM_SYNC_HAPPENED (4)
-
 const int offsetOfFirstCGIDatum = offsetof(struct CGIDataCartesian, packetNumber);
 
-
-struct binaryDataSyncState{
-	u32 state;
-	u16 charIndex; 
-};
+void resetSyncState(struct binaryDataSyncState *syncState){
+	syncState->state = SM_WAIT_1;
+	syncState->charIndex = 0;
+}
 
 
 /*
@@ -64,13 +57,24 @@ struct binaryDataSyncState{
  *
  * Consequently, fillData returns 5 when the lowest address byte of packetNumber has been written 
  * and CGI_DATA_LENGTH when the packet has been completely received.   
+ *
+ * fillData keeps the sync state in a static variable, so it can decode only one stream at a time.
+ * Use fillDataWithState with a state per stream to decode several streams (or from several threads).
  */
 int fillData(u8 input, struct CGIDataCartesian *data){
 	static struct binaryDataSyncState syncState ={SM_WAIT_1, 0};
-	switch (syncState.state){
+	return fillDataWithState(&syncState, input, data);
+}
+
+/*
+ * Same as fillData, but the sync state is provided by the caller.
+ * The state must be initialized with resetSyncState before the first call.
+ */
+int fillDataWithState(struct binaryDataSyncState *syncState, u8 input, struct CGIDataCartesian *data){
+	switch (syncState->state){
 		case SM_WAIT_1:
 			if(input == TDDE_SYNC_VAL_1){
-				syncState.state = SM_WAIT_2;
+				syncState->state = SM_WAIT_2;
 				return(1);
 			}
 			//rt_printk("SM_WAIT_1 error!");
@@ -78,46 +82,46 @@ int fillData(u8 input, struct CGIDataCartesian *data){
 
 		case SM_WAIT_2:
 			if(input == TDDE_SYNC_VAL_2){
-				syncState.state = SM_WAIT_3;
+				syncState->state = SM_WAIT_3;
 				return(2);
 			}
 			//rt_printk("SM_WAIT_2 error!");
 			if(input == TDDE_SYNC_VAL_1){
-				syncState.state = SM_WAIT_2;
+				syncState->state = SM_WAIT_2;
 				return(1);
 			}
-			syncState.state = SM_WAIT_1;
+			syncState->state = SM_WAIT_1;
 			return(0);
 
 		case SM_WAIT_3:
 			if(input == TDDE_SYNC_VAL_3){
-				syncState.state = SM_WAIT_4;
+				syncState->state = SM_WAIT_4;
 				return(3);
 			}
 			//rt_printk("SM_WAIT_3 error!");
 			if(input == TDDE_SYNC_VAL_1){
-				syncState.state = SM_WAIT_2;
+				syncState->state = SM_WAIT_2;
 				return(1);
 			}
-			syncState.state = SM_WAIT_1;
+			syncState->state = SM_WAIT_1;
 			return(0);
 
 		case SM_WAIT_4:
 			if(input == TDDE_SYNC_VAL_4){
-				syncState.state = SM_SYNC_HAPPENED;
-				syncState.charIndex = offsetOfFirstCGIDatum;
+				syncState->state = SM_SYNC_HAPPENED;
+				syncState->charIndex = offsetOfFirstCGIDatum;
 				return(offsetOfFirstCGIDatum);
 			}
 			//rt_printk("SM_WAIT_4 error!");
-			if(input == TDDE_SYNC_VAL_1)  syncState.state = SM_WAIT_2;
-			else                          syncState.state = SM_WAIT_1;
+			if(input == TDDE_SYNC_VAL_1)  syncState->state = SM_WAIT_2;
+			else                          syncState->state = SM_WAIT_1;
 			return(0);
 
 		case SM_SYNC_HAPPENED:
-			((char*)(data))[syncState.charIndex] = input;
-			if(syncState.charIndex == CGI_DATA_LENGTH - 1){
+			((char*)(data))[syncState->charIndex] = input;
+			if(syncState->charIndex == CGI_DATA_LENGTH - 1){
 				u32 sum;
-				syncState.state = SM_WAIT_1;
+				syncState->state = SM_WAIT_1;
 				sum = checkSum((void*)data, CGI_DATA_LENGTH);
 				if(data->checkSum != sum) {
 					/*
@@ -128,9 +132,9 @@ int fillData(u8 input, struct CGIDataCartesian *data){
 				}
 				return(CGI_DATA_LENGTH);
 			}
-			return(++syncState.charIndex);
+			return(++syncState->charIndex);
 		default:  //should never happen!
-			syncState.state = SM_WAIT_1;
+			syncState->state = SM_WAIT_1;
 			//rt_printk("state machine error!");
 			return(0);
 	}
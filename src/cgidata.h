@@ -263,6 +263,20 @@ struct CGIDataPolar{
 #define pi2          2.0 * 3.1415926535897932384626433
 #define packetDuration    115200.0 / ((8 + 1 + 1) * CGI_DATA_LENGTH)
 
+#define SM_WAIT_1 (0)
+#define SM_WAIT_2 (1)
+#define SM_WAIT_3 (2)
+#define SM_WAIT_4 (3)
+#define SM_SYNC_HAPPENED (4)
+
+/*
+ * State of the packet framing state machine, one per decoded stream.
+ */
+struct binaryDataSyncState{
+	u32 state;
+	u16 charIndex; 
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -270,6 +284,8 @@ extern "C" {
 
 	u32 checkSum(const void *data, unsigned int size);
 	int fillData(u8 input, struct CGIDataCartesian *data);
+	int fillDataWithState(struct binaryDataSyncState *syncState, u8 input, struct CGIDataCartesian *data);
+	void resetSyncState(struct binaryDataSyncState *syncState);
 #ifdef __cplusplus
 };
 #endif
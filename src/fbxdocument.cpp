@@ -313,6 +313,36 @@ namespace fbx {
 		}
 	}
 
+	void FBXDocument::UpdateAxisSystem(int upAxis, int upAxisSign, int frontAxis, int frontAxisSign, int coordAxis, int coordAxisSign, double unitScaleFactor)
+	{
+		if (auto global_settings = FindNode("GlobalSettings", &m_root))
+		{
+			if (auto props = FindNode("Properties70", global_settings))
+			{
+				const std::pair<const char*, int32_t> axes[] = {
+					{ "UpAxis", upAxis }, { "UpAxisSign", upAxisSign },
+					{ "FrontAxis", frontAxis }, { "FrontAxisSign", frontAxisSign },
+					{ "CoordAxis", coordAxis }, { "CoordAxisSign", coordAxisSign } };
+
+				for (size_t i = 0; i < props->children.size(); ++i)
+				{
+					std::string propName(props->children[i].properties[0].to_string(true));
+
+					for (const auto& axis : axes)
+					{
+						if (strcmp(propName.c_str(), axis.first) == 0)
+							props->children[i].properties[4].Set(axis.second);
+					}
+
+					if (strcmp(propName.c_str(), "UnitScaleFactor") == 0 || strcmp(propName.c_str(), "OriginalUnitScaleFactor") == 0)
+					{
+						props->children[i].properties[4].Set(unitScaleFactor);
+					}
+				}
+			}
+		}
+	}
+
 	void FBXDocument::CreateGlobalSettings()
 	{
 		FBXNode global_settings("GlobalSettings");
@@ -38,6 +38,8 @@ namespace fbx {
 
 		void UpdateHeader();
 		void UpdateGlobalSettings(fbx::i64 startTime, fbx::i64 stopTime, double fps);
+		// axis system of the scene values and the size of a scene unit in cm
+		void UpdateAxisSystem(int upAxis, int upAxisSign, int frontAxis, int frontAxisSign, int coordAxis, int coordAxisSign, double unitScaleFactor);
 		void UpdateDefinitions();
 		void UpdateAnimationTakeTime(fbx::i64 startTime, fbx::i64 stopTime);
 
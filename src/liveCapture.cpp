@@ -0,0 +1,624 @@
+#ifndef __EMSCRIPTEN__
+
+#include "liveCapture.h"
+#include "cgiPacketDecoder.h"
+#include "cgiConvert.h"
+#include "memoryMappedFile.h"
+#include "cgiTimeCode.h"
+
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Ws2_32.lib")
+#endif
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// split "a:b:c" into tokens, a windows device name like COM3 has no colons
+	std::vector<std::string> SplitAddress(const std::string& address)
+	{
+		std::vector<std::string> tokens;
+		size_t first = 0;
+		while (true)
+		{
+			const size_t colon = address.find(':', first);
+			tokens.push_back(address.substr(first, (colon == std::string::npos) ? std::string::npos : colon - first));
+			if (colon == std::string::npos)
+				break;
+			first = colon + 1;
+		}
+		return tokens;
+	}
+
+	bool ParseInt(const std::string& token, int& value)
+	{
+		char* end = nullptr;
+		value = static_cast<int>(strtol(token.c_str(), &end, 10));
+		return end != token.c_str() && *end == 0;
+	}
+
+#ifdef _WIN32
+	bool StartupSockets()
+	{
+		static const bool isStarted = []()
+			{
+				WSADATA data;
+				return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+			}();
+		return isStarted;
+	}
+#else
+	bool GetSerialSpeed(const int baudRate, speed_t& speed)
+	{
+		switch (baudRate)
+		{
+		case 9600: speed = B9600; return true;
+		case 19200: speed = B19200; return true;
+		case 38400: speed = B38400; return true;
+		case 57600: speed = B57600; return true;
+		case 115200: speed = B115200; return true;
+		case 230400: speed = B230400; return true;
+		default: return false;
+		}
+	}
+#endif
+}
+
+//
+// CGILiveSource
+
+CGILiveSource::~CGILiveSource()
+{
+	Close();
+}
+
+bool CGILiveSource::OpenForRead(const char* address)
+{
+	return Open(address, false);
+}
+
+bool CGILiveSource::OpenForWrite(const char* address)
+{
+	return Open(address, true);
+}
+
+bool CGILiveSource::Open(const char* address, bool isWrite)
+{
+	Close();
+
+	const std::vector<std::string> tokens = SplitAddress(address);
+	int port = 0;
+	int baudRate = 115200;
+
+	if (tokens[0] == "udp")
+	{
+		if (tokens.size() == 2 && !isWrite && ParseInt(tokens[1], port))
+			return OpenUdp(std::string(), port, false);
+		if (tokens.size() == 3 && ParseInt(tokens[2], port))
+			return OpenUdp(tokens[1], port, isWrite);
+	}
+	else if (tokens[0] == "serial" && tokens.size() >= 2)
+	{
+		// a device path can't have a colon, the last token is a baud rate when it's a number
+		std::string device = tokens[1];
+		if (tokens.size() > 2 && !ParseInt(tokens.back(), baudRate))
+			baudRate = 115200;
+
+		return OpenSerial(device, baudRate);
+	}
+
+	printf("Wrong live address %s, please use udp:<port>, udp:<host>:<port> or serial:<device>[:<baud rate>]\n", address);
+	return false;
+}
+
+#ifdef _WIN32
+
+bool CGILiveSource::OpenUdp(const std::string& host, int port, bool isWrite)
+{
+	if (!StartupSockets())
+		return false;
+
+	SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == INVALID_SOCKET)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(sockaddr_in));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(static_cast<u_short>(port));
+
+	if (isWrite)
+	{
+		if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+		{
+			closesocket(s);
+			return false;
+		}
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&address);
+		m_TargetAddress.assign(bytes, bytes + sizeof(sockaddr_in));
+	}
+	else
+	{
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		if (!host.empty())
+			inet_pton(AF_INET, host.c_str(), &address.sin_addr);
+
+		// a bigger receive buffer survives a short stall of the reader
+		const int bufferSize = 1 << 20;
+		setsockopt(s, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&bufferSize), sizeof(int));
+
+		if (bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(sockaddr_in)) != 0)
+		{
+			closesocket(s);
+			return false;
+		}
+	}
+
+	m_Socket = static_cast<uintptr_t>(s);
+	m_Kind = Kind::Udp;
+	return true;
+}
+
+bool CGILiveSource::OpenSerial(const std::string& device, int baudRate)
+{
+	const std::string path = "\\\\.\\" + device;
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, 0, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	DCB dcb;
+	memset(&dcb, 0, sizeof(DCB));
+	dcb.DCBlength = sizeof(DCB);
+	GetCommState(handle, &dcb);
+	dcb.BaudRate = static_cast<DWORD>(baudRate);
+	dcb.ByteSize = 8;
+	dcb.Parity = NOPARITY;
+	dcb.StopBits = ONESTOPBIT;
+	dcb.fBinary = TRUE;
+
+	COMMTIMEOUTS timeouts;
+	memset(&timeouts, 0, sizeof(COMMTIMEOUTS));
+	timeouts.ReadIntervalTimeout = MAXDWORD;
+	timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+	timeouts.ReadTotalTimeoutConstant = 100;
+
+	if (!SetCommState(handle, &dcb) || !SetCommTimeouts(handle, &timeouts))
+	{
+		CloseHandle(handle);
+		return false;
+	}
+
+	m_SerialHandle = handle;
+	m_Kind = Kind::Serial;
+	return true;
+}
+
+void CGILiveSource::Close()
+{
+	if (m_Kind == Kind::Udp)
+	{
+		closesocket(static_cast<SOCKET>(m_Socket));
+		m_Socket = ~uintptr_t(0);
+	}
+	else if (m_Kind == Kind::Serial)
+	{
+		CloseHandle(m_SerialHandle);
+		m_SerialHandle = nullptr;
+	}
+	m_Kind = Kind::None;
+	m_TargetAddress.clear();
+}
+
+int CGILiveSource::Read(uint8_t* buffer, size_t size, int timeoutMs)
+{
+	if (m_Kind == Kind::Udp)
+	{
+		const SOCKET s = static_cast<SOCKET>(m_Socket);
+
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(s, &readSet);
+		timeval timeout{ timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+
+		const int status = select(0, &readSet, nullptr, nullptr, &timeout);
+		if (status <= 0)
+			return status;
+
+		const int received = recv(s, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0);
+		return (received >= 0) ? received : -1;
+	}
+	else if (m_Kind == Kind::Serial)
+	{
+		// the read timeout is set by SetCommTimeouts
+		DWORD received = 0;
+		if (!ReadFile(m_SerialHandle, buffer, static_cast<DWORD>(size), &received, nullptr))
+			return -1;
+		return static_cast<int>(received);
+	}
+	return -1;
+}
+
+bool CGILiveSource::Write(const uint8_t* buffer, size_t size)
+{
+	if (m_Kind == Kind::Udp)
+	{
+		return sendto(static_cast<SOCKET>(m_Socket), reinterpret_cast<const char*>(buffer), static_cast<int>(size), 0,
+			reinterpret_cast<const sockaddr*>(m_TargetAddress.data()), static_cast<int>(m_TargetAddress.size())) == static_cast<int>(size);
+	}
+	else if (m_Kind == Kind::Serial)
+	{
+		DWORD written = 0;
+		return WriteFile(m_SerialHandle, buffer, static_cast<DWORD>(size), &written, nullptr) && written == size;
+	}
+	return false;
+}
+
+#else
+
+bool CGILiveSource::OpenUdp(const std::string& host, int port, bool isWrite)
+{
+	const int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s < 0)
+		return false;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(sockaddr_in));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(static_cast<uint16_t>(port));
+
+	if (isWrite)
+	{
+		if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1)
+		{
+			close(s);
+			return false;
+		}
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&address);
+		m_TargetAddress.assign(bytes, bytes + sizeof(sockaddr_in));
+	}
+	else
+	{
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		if (!host.empty())
+			inet_pton(AF_INET, host.c_str(), &address.sin_addr);
+
+		// a bigger receive buffer survives a short stall of the reader
+		const int bufferSize = 1 << 20;
+		setsockopt(s, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(int));
+
+		if (bind(s, reinterpret_cast<const sockaddr*>(&address), sizeof(sockaddr_in)) != 0)
+		{
+			close(s);
+			return false;
+		}
+	}
+
+	m_Descriptor = s;
+	m_Kind = Kind::Udp;
+	return true;
+}
+
+bool CGILiveSource::OpenSerial(const std::string& device, int baudRate)
+{
+	speed_t speed;
+	if (!GetSerialSpeed(baudRate, speed))
+	{
+		printf("Unsupported serial baud rate %d, please use 9600, 19200, 38400, 57600, 115200 or 230400\n", baudRate);
+		return false;
+	}
+
+	const int fd = open(device.c_str(), O_RDWR | O_NOCTTY);
+	if (fd < 0)
+		return false;
+
+	termios options;
+	if (tcgetattr(fd, &options) == 0)
+	{
+		// raw 8N1
+		cfmakeraw(&options);
+		cfsetispeed(&options, speed);
+		cfsetospeed(&options, speed);
+		options.c_cflag |= (CLOCAL | CREAD);
+		options.c_cflag &= ~(PARENB | CSTOPB);
+		tcsetattr(fd, TCSANOW, &options);
+	}
+
+	m_Descriptor = fd;
+	m_Kind = Kind::Serial;
+	return true;
+}
+
+void CGILiveSource::Close()
+{
+	if (m_Descriptor >= 0)
+	{
+		close(m_Descriptor);
+		m_Descriptor = -1;
+	}
+	m_Kind = Kind::None;
+	m_TargetAddress.clear();
+}
+
+int CGILiveSource::Read(uint8_t* buffer, size_t size, int timeoutMs)
+{
+	if (m_Descriptor < 0)
+		return -1;
+
+	pollfd request;
+	request.fd = m_Descriptor;
+	request.events = POLLIN;
+	request.revents = 0;
+
+	const int status = poll(&request, 1, timeoutMs);
+	if (status <= 0)
+		return status;
+
+	const ssize_t received = read(m_Descriptor, buffer, size);
+	return (received >= 0) ? static_cast<int>(received) : -1;
+}
+
+bool CGILiveSource::Write(const uint8_t* buffer, size_t size)
+{
+	if (m_Kind == Kind::Udp)
+	{
+		return sendto(m_Descriptor, buffer, size, 0, reinterpret_cast<const sockaddr*>(m_TargetAddress.data()),
+			static_cast<socklen_t>(m_TargetAddress.size())) == static_cast<ssize_t>(size);
+	}
+	else if (m_Kind == Kind::Serial)
+	{
+		return write(m_Descriptor, buffer, size) == static_cast<ssize_t>(size);
+	}
+	return false;
+}
+
+#endif
+
+//
+// CGILiveCapture
+
+CGILiveCapture::~CGILiveCapture()
+{
+	Stop();
+}
+
+double CGILiveCapture::GetKeySecond(const timeCodeStruct& timeCode, double frameRate)
+{
+	return KeyTimeToSeconds(TimeCodeToKeyTime(timeCode, CGIFrameRate::FromDouble(frameRate)));
+}
+
+bool CGILiveCapture::Start(const char* address, double frameRate, double windowSeconds)
+{
+	Stop();
+
+	if (!m_Source.OpenForRead(address))
+	{
+		printf("Failed to open the live source %s\n", address);
+		return false;
+	}
+
+	m_FrameRate = frameRate;
+	m_TimeCodeRate = CGIFrameRate::FromDouble(frameRate);
+	m_WindowSeconds = windowSeconds;
+	m_NumberOfReceivedPackets = 0;
+	m_NumberOfDroppedPackets = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_WindowMutex);
+		m_WindowPackets.clear();
+		m_WindowTimes.clear();
+	}
+
+	m_IsRunning = true;
+	m_Producer = std::thread(&CGILiveCapture::ProducerLoop, this);
+	m_Consumer = std::thread(&CGILiveCapture::ConsumerLoop, this);
+	return true;
+}
+
+void CGILiveCapture::Stop()
+{
+	m_IsRunning = false;
+
+	if (m_Producer.joinable())
+		m_Producer.join();
+	if (m_Consumer.joinable())
+		m_Consumer.join();
+
+	m_Source.Close();
+}
+
+void CGILiveCapture::ProducerLoop()
+{
+	// a read returns at least every timeout, so the loop sees the stop request
+	constexpr int read_timeout_ms = 100;
+
+	CGIPacketDecoder decoder;
+	std::vector<uint8_t> buffer(64 * 1024);
+	std::vector<CGIDataCartesian> packets;
+
+	while (m_IsRunning)
+	{
+		const int received = m_Source.Read(buffer.data(), buffer.size(), read_timeout_ms);
+		if (received < 0)
+		{
+			printf("Live source read error, the capture is stopped\n");
+			m_IsRunning = false;
+			break;
+		}
+
+		packets.clear();
+		decoder.Feed(buffer.data(), static_cast<size_t>(received), packets);
+
+		for (const CGIDataCartesian& packet : packets)
+		{
+			m_NumberOfReceivedPackets += 1;
+			if (!m_Ring.TryPush(packet))
+				m_NumberOfDroppedPackets += 1;
+		}
+	}
+}
+
+void CGILiveCapture::ConsumerLoop()
+{
+	constexpr size_t max_bulk = 256;
+	CGIDataCartesian packets[max_bulk];
+
+	while (true)
+	{
+		const size_t count = m_Ring.PopBulk(packets, max_bulk);
+		if (count > 0)
+		{
+			AddToWindow(packets, count);
+		}
+		else if (!m_IsRunning)
+		{
+			break;
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+}
+
+void CGILiveCapture::AddToWindow(const CGIDataCartesian* packets, size_t count)
+{
+	std::lock_guard<std::mutex> lock(m_WindowMutex);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const double time = KeyTimeToSeconds(TimeCodeToKeyTime(packets[i].timeCode, m_TimeCodeRate));
+
+		if (!m_WindowTimes.empty() && time < m_WindowTimes.back() - m_WindowSeconds)
+		{
+			// timecode jumped back out of the window, a new take starts
+			m_WindowPackets.clear();
+			m_WindowTimes.clear();
+		}
+
+		if (m_WindowTimes.empty() || time >= m_WindowTimes.back())
+		{
+			m_WindowPackets.push_back(packets[i]);
+			m_WindowTimes.push_back(time);
+		}
+		else
+		{
+			// a late datagram, keep the window in the timecode order
+			const auto iter = std::upper_bound(begin(m_WindowTimes), end(m_WindowTimes), time);
+			m_WindowPackets.insert(begin(m_WindowPackets) + (iter - begin(m_WindowTimes)), packets[i]);
+			m_WindowTimes.insert(iter, time);
+		}
+	}
+
+	// drop packets out of the window
+	const double lastTime = m_WindowTimes.back();
+	while (m_WindowTimes.front() < lastTime - m_WindowSeconds)
+	{
+		m_WindowTimes.pop_front();
+		m_WindowPackets.pop_front();
+	}
+}
+
+size_t CGILiveCapture::CopyWindow(double startTime, double endTime, std::vector<CGIDataCartesian>& packets) const
+{
+	packets.clear();
+
+	std::lock_guard<std::mutex> lock(m_WindowMutex);
+
+	const auto first = std::lower_bound(begin(m_WindowTimes), end(m_WindowTimes), startTime);
+	const auto last = (endTime > 0.0) ? std::upper_bound(first, end(m_WindowTimes), endTime) : end(m_WindowTimes);
+
+	packets.assign(begin(m_WindowPackets) + (first - begin(m_WindowTimes)), begin(m_WindowPackets) + (last - begin(m_WindowTimes)));
+	return packets.size();
+}
+
+size_t CGILiveCapture::CopyLastSeconds(double seconds, std::vector<CGIDataCartesian>& packets) const
+{
+	double firstTime, lastTime;
+	if (!GetWindowSpan(firstTime, lastTime))
+	{
+		packets.clear();
+		return 0;
+	}
+	return CopyWindow(lastTime - seconds, 0.0, packets);
+}
+
+bool CGILiveCapture::GetWindowSpan(double& firstTime, double& lastTime) const
+{
+	std::lock_guard<std::mutex> lock(m_WindowMutex);
+	if (m_WindowTimes.empty())
+		return false;
+
+	firstTime = m_WindowTimes.front();
+	lastTime = m_WindowTimes.back();
+	return true;
+}
+
+size_t CGILiveCapture::GetWindowSize() const
+{
+	std::lock_guard<std::mutex> lock(m_WindowMutex);
+	return m_WindowPackets.size();
+}
+
+//
+// replay
+
+int ReplayRecording(const char* filename, const char* address, double frameRate)
+{
+	MemoryMappedFile file;
+	CGIConvert cgiConvert;
+	if (!file.Open(filename) || !cgiConvert.LoadPackets(file.GetData(), file.GetSize(), static_cast<float>(frameRate))
+		|| cgiConvert.IsEmpty())
+	{
+		printf("Failed to load the recording %s\n", filename);
+		return -1;
+	}
+
+	CGILiveSource target;
+	if (!target.OpenForWrite(address))
+	{
+		printf("Failed to open the live target %s\n", address);
+		return -1;
+	}
+
+	const int numberOfPackets = cgiConvert.GetNumberOfPackets();
+	printf("Replay %d packets of %s to %s\n", numberOfPackets, filename, address);
+
+	// packets are sent in the timecode order, a packet per datagram, paced by the packet key times
+	const auto replayStart = std::chrono::steady_clock::now();
+	const double firstTime = CGILiveCapture::GetKeySecond(cgiConvert.GetPacket(0).timeCode, frameRate);
+
+	int numberOfSent = 0;
+	for (int i = 0; i < numberOfPackets; ++i)
+	{
+		const CGIDataCartesian& packet = cgiConvert.GetPacket(i);
+		const double delay = CGILiveCapture::GetKeySecond(packet.timeCode, frameRate) - firstTime;
+		std::this_thread::sleep_until(replayStart + std::chrono::duration<double>(delay));
+
+		if (target.Write(reinterpret_cast<const uint8_t*>(&packet), sizeof(CGIDataCartesian)))
+			numberOfSent += 1;
+	}
+
+	printf("Sent %d packets\n", numberOfSent);
+	return numberOfSent;
+}
+
+#endif
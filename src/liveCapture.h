@@ -0,0 +1,171 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+#include "cgidata.h"
+#include "ringBuffer.h"
+#include "cgiTimeCode.h"
+
+/// <summary>
+/// A live byte stream of cgi packets, a local udp port or a serial device
+///  address format
+///   udp:<port> - receive datagrams on a local port
+///   udp:<host>:<port> - send datagrams to a host (replay)
+///   serial:<device>[:<baud rate>] - serial device, like serial:/dev/ttyUSB0 or serial:COM3:115200
+/// </summary>
+class CGILiveSource
+{
+public:
+
+	CGILiveSource() = default;
+	~CGILiveSource();
+
+	CGILiveSource(const CGILiveSource&) = delete;
+	CGILiveSource& operator=(const CGILiveSource&) = delete;
+
+	/// <summary>
+	/// open the source to receive packets
+	/// </summary>
+	bool OpenForRead(const char* address);
+
+	/// <summary>
+	/// open the source to send packets, used to replay a recording
+	/// </summary>
+	bool OpenForWrite(const char* address);
+
+	void Close();
+
+	bool IsOpen() const { return m_Kind != Kind::None; }
+
+	/// <summary>
+	/// wait up to timeout for the next received bytes
+	/// </summary>
+	/// <returns>number of received bytes, 0 on timeout, -1 on error</returns>
+	int Read(uint8_t* buffer, size_t size, int timeoutMs);
+
+	bool Write(const uint8_t* buffer, size_t size);
+
+private:
+
+	enum class Kind : uint8_t
+	{
+		None,
+		Udp,
+		Serial
+	};
+
+	Kind	m_Kind{ Kind::None };
+
+#ifdef _WIN32
+	uintptr_t	m_Socket{ ~uintptr_t(0) };
+	void*		m_SerialHandle{ nullptr };
+#else
+	int			m_Descriptor{ -1 };
+#endif
+
+	/// udp target of a replay, sockaddr_in
+	std::vector<uint8_t>	m_TargetAddress;
+
+	bool Open(const char* address, bool isWrite);
+	bool OpenUdp(const std::string& host, int port, bool isWrite);
+	bool OpenSerial(const std::string& device, int baudRate);
+};
+
+/// <summary>
+/// Live capture of a cgi stream
+///  A producer thread reads the source, frames packets and pushes them into a lock-free
+/// single producer / single consumer ring. A consumer thread pops the packets, computes their
+/// key times and keeps a rolling window of the latest packets in timecode order,
+/// so an export of the window needs no load, sort or scan pass
+/// </summary>
+class CGILiveCapture
+{
+public:
+
+	CGILiveCapture()
+		: m_Ring(1 << 14)
+	{}
+
+	~CGILiveCapture();
+
+	/// <summary>
+	/// open the source and start the capture threads
+	/// </summary>
+	/// <param name="address">see CGILiveSource</param>
+	/// <param name="frameRate">frame rate of timecodes</param>
+	/// <param name="windowSeconds">length of the rolling window</param>
+	bool Start(const char* address, double frameRate, double windowSeconds);
+
+	void Stop();
+
+	bool IsRunning() const { return m_IsRunning; }
+
+	/// <summary>
+	/// copy window packets with a key time within [startTime; endTime] seconds, endTime <= 0 means up to the latest packet
+	/// </summary>
+	/// <returns>number of copied packets</returns>
+	size_t CopyWindow(double startTime, double endTime, std::vector<CGIDataCartesian>& packets) const;
+
+	/// <summary>
+	/// copy window packets of the last given seconds
+	/// </summary>
+	size_t CopyLastSeconds(double seconds, std::vector<CGIDataCartesian>& packets) const;
+
+	/// <summary>
+	/// key time span of the window in seconds, returns false when the window is empty
+	/// </summary>
+	bool GetWindowSpan(double& firstTime, double& lastTime) const;
+
+	size_t GetWindowSize() const;
+
+	size_t GetNumberOfReceivedPackets() const { return m_NumberOfReceivedPackets; }
+
+	/// <summary>
+	/// packets lost because the consumer could not keep up and the ring was full
+	/// </summary>
+	size_t GetNumberOfDroppedPackets() const { return m_NumberOfDroppedPackets; }
+
+	double GetFrameRate() const { return m_FrameRate; }
+
+	/// <summary>
+	/// key time of a timecode in seconds, the same value the packets columns use
+	/// </summary>
+	static double GetKeySecond(const timeCodeStruct& timeCode, double frameRate);
+
+private:
+
+	CGILiveSource		m_Source;
+	SPSCRingBuffer<CGIDataCartesian>	m_Ring;
+
+	double				m_FrameRate{ 25.0 };
+	CGIFrameRate		m_TimeCodeRate;
+	double				m_WindowSeconds{ 300.0 };
+
+	std::atomic<bool>	m_IsRunning{ false };
+	std::atomic<size_t>	m_NumberOfReceivedPackets{ 0 };
+	std::atomic<size_t>	m_NumberOfDroppedPackets{ 0 };
+
+	std::thread			m_Producer;
+	std::thread			m_Consumer;
+
+	// rolling window, ordered by key time
+	mutable std::mutex				m_WindowMutex;
+	std::deque<CGIDataCartesian>	m_WindowPackets;
+	std::deque<double>				m_WindowTimes;
+
+	void ProducerLoop();
+	void ConsumerLoop();
+	void AddToWindow(const CGIDataCartesian* packets, size_t count);
+};
+
+/// <summary>
+/// send packets of a recording to a live address in the timecode order, paced by the frame rate
+///  a local tool to test the live capture
+/// </summary>
+/// <returns>number of sent packets, -1 on error</returns>
+int ReplayRecording(const char* filename, const char* address, double frameRate);
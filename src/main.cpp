@@ -2,6 +2,7 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <string>
 #include <array>
 #include <algorithm>
 #include "cgidata.h"
@@ -16,6 +17,21 @@
 #include "fbxtime.h"
 #include "fbxutil.h"
 #include "cgiConvert.h"
+#include "cgiSession.h"
+#include "cgiRecordingIndex.h"
+#include "memoryMappedFile.h"
+#include "batchJobs.h"
+#include "parallelFor.h"
+#include "cgiLog.h"
+
+#ifndef __EMSCRIPTEN__
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <memory>
+#include "liveCapture.h"
+#endif
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -38,28 +54,53 @@
 
 
 /// <summary>
-/// Print to console information about raw *.cgi stream, like start / stop timecodes
+/// Print to console start / stop timecodes, the estimated frame rate and the longest data gaps of a recording
 /// </summary>
-/// <param name="buffer">a stream data buffer</param>
-/// <param name="size">size of a stream in bytes</param>
+void PrintStatistics(const CGIStatistics& statistics, double frameRate)
+{
+	const timeCodeStruct& firstTimeCode = statistics.firstTimeCode;
+	const timeCodeStruct& lastTimeCode = statistics.lastTimeCode;
+
+	printf("Start TimeCode %u:%u:%u:%u\n", firstTimeCode.hours, firstTimeCode.minutes, firstTimeCode.seconds,
+		firstTimeCode.frames);
+	printf("End TimeCode %u:%u:%u:%u\n", lastTimeCode.hours, lastTimeCode.minutes, lastTimeCode.seconds,
+		lastTimeCode.frames);
+
+	printf("User defined frame rate %d, the data estimated frame rate %d\n", static_cast<int>(frameRate), statistics.estimatedFrameRate);
+
+	if (!statistics.gaps.empty())
+	{
+		printf("== Data Gaps ==\n");
+
+		for (const CGIDataGap& gap : statistics.gaps)
+		{
+			printf("No Data between timecode %u:%u:%u:%u and timecode %u:%u:%u:%u, gap duration %.2f seconds\n",
+				gap.prevTimeCode.hours, gap.prevTimeCode.minutes, gap.prevTimeCode.seconds, gap.prevTimeCode.frames,
+				gap.timeCode.hours, gap.timeCode.minutes, gap.timeCode.seconds, gap.timeCode.frames,
+				gap.duration);
+		}
+
+		printf("==========\n");
+	}
+}
+
+/// <summary>
+/// Print to console information about loaded packets, like start / stop timecodes
+/// </summary>
+/// <param name="cgiConvert">loaded packets</param>
 /// <param name="frameRate">a given frame rate of packets in the stream</param>
+/// <param name="statistics">computed statistics of the packets</param>
 /// <returns>status of a print, 0 - successful</returns>
-EXTERN int PrintCGIInfo(uint8_t* buffer, size_t size, double frameRate, bool printTimecodes=false)
+int PrintPacketsInfo(CGIConvert& cgiConvert, double frameRate, bool printTimecodes, CGIStatistics& statistics)
 {
-	CGIConvert cgiConvert;
-	cgiConvert.LoadPackets(buffer, size, static_cast<float>(frameRate));
-
 	printf("Loaded packets - %d\n", cgiConvert.GetNumberOfPackets());
 	if (cgiConvert.IsEmpty())
 		return -1;
 
-	const CGIDataCartesian& firstPacket = cgiConvert.GetPacket(0);
-	const CGIDataCartesian& lastPacket = cgiConvert.GetPacket(cgiConvert.GetNumberOfPackets() - 1);
-
-	printf("Start TimeCode %u:%u:%u:%u\n", firstPacket.timeCode.hours, firstPacket.timeCode.minutes, firstPacket.timeCode.seconds,
-		firstPacket.timeCode.frames);
-	printf("End TimeCode %u:%u:%u:%u\n", lastPacket.timeCode.hours, lastPacket.timeCode.minutes, lastPacket.timeCode.seconds,
-		lastPacket.timeCode.frames);
+	// the statistics pass reads only the timecode, frame index, key time and packet number columns
+	cgiConvert.BuildColumns(frameRate);
+	const std::vector<timeCodeStruct>& timeCodes = cgiConvert.GetColumns().timeCode;
+	const int numberOfPackets = static_cast<int>(timeCodes.size());
 
 	if (printTimecodes)
 	{
@@ -69,13 +110,13 @@ EXTERN int PrintCGIInfo(uint8_t* buffer, size_t size, double frameRate, bool pri
 		if (err == 0 && f != nullptr)
 		{
 			char temp[128]{ 0 };
-			for (int i = 0; i < cgiConvert.GetNumberOfPackets(); ++i)
+			for (int i = 0; i < numberOfPackets; ++i)
 			{
-				const CGIDataCartesian& packet = cgiConvert.GetPacket(i);
+				const timeCodeStruct& timeCode = timeCodes[i];
 
 				memset(temp, 0, sizeof(char) * 128);
-				sprintf_s(temp, sizeof(char) * 128, "%u:%u:%u:%u\n", packet.timeCode.hours, packet.timeCode.minutes, packet.timeCode.seconds,
-					packet.timeCode.frames);
+				sprintf_s(temp, sizeof(char) * 128, "%u:%u:%u:%u\n", timeCode.hours, timeCode.minutes, timeCode.seconds,
+					timeCode.frames);
 
 				fwrite(temp, sizeof(char), strlen(temp), f);
 			}
@@ -84,108 +125,38 @@ EXTERN int PrintCGIInfo(uint8_t* buffer, size_t size, double frameRate, bool pri
 		}
 #endif
 	}
-	
-	// print out the longest data gaps
-
-	auto fn_getSec = [](uint32_t hours, uint32_t minutes, uint32_t seconds, uint32_t frames, double fps) -> double
-		{
-			return 3600.0 * static_cast<double>(hours) + 60.0 * static_cast<double>(minutes)
-				+ static_cast<double>(seconds) + std::min(1.0, static_cast<double>(frames) / fps);
-		};
-
-	// <frame rate, number of packets used it>
-	std::vector<std::pair<int, float>> packetMag;
-	
-	constexpr int max_printed_gaps = 6;
-	constexpr float time_thres{ 1.0f };
-	
-	std::unordered_map<int, int> packetRates;
-
-	// calculate all combinations of timecodes and how many frames are in use
-
-	for (int i = 1; i < cgiConvert.GetNumberOfPackets(); ++i)
-	{
-		const CGIDataCartesian& prevPacket = cgiConvert.GetPacket(i-1);
-		const CGIDataCartesian& thePacket = cgiConvert.GetPacket(i);
-
-		const double prevTime = fn_getSec(prevPacket.timeCode.hours, prevPacket.timeCode.minutes, prevPacket.timeCode.seconds, prevPacket.timeCode.frames, frameRate);
-		const double currTime = fn_getSec(thePacket.timeCode.hours, thePacket.timeCode.minutes, thePacket.timeCode.seconds, thePacket.timeCode.frames, frameRate);
 
-		if (currTime - prevTime < 1.0f)
-		{
-			if (prevPacket.timeCode.frames > thePacket.timeCode.frames)
-			{
-				const int lastFrameRate = prevPacket.timeCode.frames + 1;
-				auto iter = packetRates.find(lastFrameRate);
-				if (iter != end(packetRates))
-				{
-					iter->second += 1;
-				}
-				else
-				{
-					packetRates.emplace(lastFrameRate, 1);
-				}
-			}
-		}
+	ComputeStatistics(cgiConvert.GetColumns(), statistics);
+	PrintStatistics(statistics, frameRate);
 		
-		if ((currTime - prevTime) > time_thres)
-		{
-			packetMag.emplace_back(i, static_cast<float>(currTime - prevTime));
-		}
-	}
-
-	//
-	// compute estimated frame rate
-
-	int myEstimatedRate = 0;
-	int frameRatePackets = 0;
-
-	for (const auto& iter : packetRates)
-	{
-		if (iter.second > frameRatePackets)
-		{
-			myEstimatedRate = iter.first;
-			frameRatePackets = iter.second;
-		}
-	}
-
-	printf("User defined frame rate %d, the data estimated frame rate %d\n", static_cast<int>(frameRate), myEstimatedRate);
-
-	//
-	// compute gaps
-
-	std::sort(begin(packetMag), end(packetMag), [](const std::pair<int, float>& a, const std::pair<int, float>& b)
-		{
-			return a.second > b.second;
-		});
-
-	const bool hasAnyGap = (!packetMag.empty() && packetMag[0].second >= time_thres);
-	if (hasAnyGap)
-	{
-		printf("== Data Gaps ==\n");
-
-		for (int i = 0; i < max_printed_gaps; ++i)
-		{
-			if (packetMag[i].second < time_thres)
-				break;
+	return 0;
+}
 
-			const int packetIndex = packetMag[i].first;
-			const CGIDataCartesian& prevPacket = cgiConvert.GetPacket(packetIndex - 1);
-			const CGIDataCartesian& thePacket = cgiConvert.GetPacket(packetIndex);
+int PrintPacketsInfo(CGIConvert& cgiConvert, double frameRate, bool printTimecodes)
+{
+	CGIStatistics statistics;
+	return PrintPacketsInfo(cgiConvert, frameRate, printTimecodes, statistics);
+}
 
-			printf("No Data between timecode %u:%u:%u:%u and timecode %u:%u:%u:%u, gap duration %.2f seconds\n",
-				prevPacket.timeCode.hours, prevPacket.timeCode.minutes, prevPacket.timeCode.seconds, prevPacket.timeCode.frames,
-				thePacket.timeCode.hours, thePacket.timeCode.minutes, thePacket.timeCode.seconds, thePacket.timeCode.frames,
-				packetMag[i].second);
-		}
+/// <summary>
+/// Print to console information about raw *.cgi stream, like start / stop timecodes
+/// </summary>
+/// <param name="buffer">a stream data buffer</param>
+/// <param name="size">size of a stream in bytes</param>
+/// <param name="frameRate">a given frame rate of packets in the stream</param>
+/// <returns>status of a print, 0 - successful</returns>
+EXTERN int PrintCGIInfo(const uint8_t* buffer, size_t size, double frameRate, bool printTimecodes=false)
+{
+	CGIConvert cgiConvert;
+	cgiConvert.LoadPackets(buffer, size, static_cast<float>(frameRate));
 
-		printf("==========\n");
-	}
-		
-	return 0;
+	return PrintPacketsInfo(cgiConvert, frameRate, printTimecodes);
 }
 
-bool PrepareCameraAnimation(fbx::Scene& scene, CGIConvert& cgiConvert, double startTime, double endTime, double fps)
+/// <summary>
+/// fill camera animation curves of a template scene with keys of sorted packets [firstKey; lastKey)
+/// </summary>
+bool PrepareCameraAnimation(fbx::Scene& scene, CGIConvert& cgiConvert, size_t firstKey, size_t lastKey, double fps, bool isVerbose)
 {
 	auto node = scene.FindModel("TDCamera");
 	if (node == nullptr)
@@ -196,7 +167,7 @@ bool PrepareCameraAnimation(fbx::Scene& scene, CGIConvert& cgiConvert, double st
 
 	if (node->GetNodeAttribute() == nullptr)
 	{
-		printf("ERROR: node attribute is empty\n");
+		LogPrintf("ERROR: node attribute is empty\n");
 		return false;
 	}
 
@@ -220,7 +191,7 @@ bool PrepareCameraAnimation(fbx::Scene& scene, CGIConvert& cgiConvert, double st
 		|| !fieldOfViewNode || !focusDistanceNode || !zoomNode || !focusNode
 		|| !tcHourNode || !tcMinuteNode || !tcSecondNode || !tcFrameNode)
 	{
-		printf("ERROR: not all template animation nodes are found!\n");
+		LogPrintf("ERROR: not all template animation nodes are found!\n");
 		return false;
 	}
 		
@@ -248,281 +219,1405 @@ bool PrepareCameraAnimation(fbx::Scene& scene, CGIConvert& cgiConvert, double st
 	auto tcFrameCurve = tcFrameNode->GetCurve(0);
 	auto tcRateCurve = tcRateNode->GetCurve(0);
 	
-	const int keyCount = cgiConvert.GetNumberOfPackets();
-	const bool hasTrimRegion = (endTime > 0.0);
-	int realKeyCount = (hasTrimRegion) ? 0 : keyCount;
+	// packets are processed as columns, a pass reads only the channels it needs
+	cgiConvert.BuildColumns(fps);
+	const CGIPacketColumns& packetColumns = cgiConvert.GetColumns();
 
-	timeCodeStruct leftTimeCode = cgiConvert.GetPacket(0).timeCode;
-	timeCodeStruct rightTimeCode = cgiConvert.GetPacket(0).timeCode;
+	// TRIM OPERATION, keys of a sorted packets range
 
-	if (hasTrimRegion)
+	if (lastKey <= firstKey)
 	{
-		for (int i = 0; i < keyCount; ++i)
-		{
-			const auto& packet = cgiConvert.GetPacket(i);
-			fbx::OFBTime time(packet.timeCode.hours, packet.timeCode.minutes, packet.timeCode.seconds, packet.timeCode.frames, 0, fbx::OFBTimeMode::eCustom, fps);
+		const timeCodeStruct& leftTimeCode = packetColumns.timeCode[(firstKey > 0) ? firstKey - 1 : 0];
+		const timeCodeStruct& rightTimeCode = packetColumns.timeCode[(lastKey < packetColumns.Count()) ? lastKey : 0];
 
-			// TRIM OPERATION
-			const double timeSec = time.GetSecondDouble();
-			if (timeSec < startTime)
-			{
-				leftTimeCode = packet.timeCode;
-				continue;
-			}
-			else if (timeSec > endTime)
-			{
-				rightTimeCode = packet.timeCode;
-				break;
-			}
-			
-			realKeyCount += 1;
-		}
+		LogPrintf("ERROR: your defined timecode range doesn't contain any keys!\n");
+		LogPrintf("  Please use timecode before %u:%u:%u:%u or after %u:%u:%u:%u\n", leftTimeCode.hours, leftTimeCode.minutes, leftTimeCode.seconds, leftTimeCode.frames,
+			rightTimeCode.hours, rightTimeCode.minutes, rightTimeCode.seconds, rightTimeCode.frames);
+		return false;
+	}
+
+	// low-pass filter of the encoders noise, packets around the range are the filter context
+	CGIPacketColumns filteredColumns;
+	const bool isFiltered = cgiConvert.GetFiltering().isEnabled;
+	if (isFiltered)
+	{
+		FilterColumns(packetColumns, firstKey, lastKey, cgiConvert.GetFiltering(), filteredColumns);
+		firstKey = 0;
+		lastKey = filteredColumns.Count();
+	}
+
+	const CGIPacketColumns& sourceColumns = (isFiltered) ? filteredColumns : packetColumns;
+
+	// keys on the output frame grid instead of a key per packet
+	CGIPacketColumns resampledColumns;
+	const bool isResampled = cgiConvert.GetResampling().IsEnabled();
+	if (isResampled)
+	{
+		ResampleColumns(sourceColumns, firstKey, lastKey, cgiConvert.GetResampling(), resampledColumns);
+		firstKey = 0;
+		lastKey = resampledColumns.Count();
 	}
 
+	const CGIPacketColumns& columns = (isResampled) ? resampledColumns : sourceColumns;
+	const int realKeyCount = (lastKey > firstKey) ? static_cast<int>(lastKey - firstKey) : 0;
+
 	if (realKeyCount <= 0)
 	{
-		printf("ERROR: your defined timecode range doesn't contain any keys!\n");
-		printf("  Please use timecode before %u:%u:%u:%u or after %u:%u:%u:%u\n", leftTimeCode.hours, leftTimeCode.minutes, leftTimeCode.seconds, leftTimeCode.frames,
-			rightTimeCode.hours, rightTimeCode.minutes, rightTimeCode.seconds, rightTimeCode.frames);
+		LogPrintf("ERROR: no keys on the output frame grid in the timecode range!\n");
 		return false;
 	}
 	
-	posX->SetKeyCount(realKeyCount);
-	posY->SetKeyCount(realKeyCount);
-	posZ->SetKeyCount(realKeyCount);
-
-	rotX->SetKeyCount(realKeyCount);
-	rotY->SetKeyCount(realKeyCount);
-	rotZ->SetKeyCount(realKeyCount);
-
-	// camera attribute processed values
-	if (cgiConvert.IsCalibratedCGI())
-	{
-		fieldOfViewCurve->SetKeyCount(realKeyCount);
-		focusDistanceCurve->SetKeyCount(realKeyCount);
-	}
-
-	// raw values
-	zoomCurve->SetKeyCount(realKeyCount);
-	focusCurve->SetKeyCount(realKeyCount);
-	irisCurve->SetKeyCount(realKeyCount);
-	trackPosCurve->SetKeyCount(realKeyCount);
-	packetNumberCurve->SetKeyCount(realKeyCount);
-	packetNumberCurve->SetKeyConstFlags();
-
-	tcHourCurve->SetKeyCount(realKeyCount);
-	tcHourCurve->SetKeyConstFlags();
-	tcMinuteCurve->SetKeyCount(realKeyCount);
-	tcMinuteCurve->SetKeyConstFlags();
-	tcSecondCurve->SetKeyCount(realKeyCount);
-	tcSecondCurve->SetKeyConstFlags();
-	tcFrameCurve->SetKeyCount(realKeyCount);
-	tcFrameCurve->SetKeyConstFlags();
-	tcRateCurve->SetKeyCount(1);
-	tcRateCurve->SetKeyConstFlags();
-	tcRateCurve->SetKey(0, fbx::OFBTime(0), static_cast<float>(fps));
-
-	realKeyCount = 0;
-	for (int i = 0; i < keyCount; ++i)
+	// all curves of the take share one key time buffer, it's filled once
+	const fbx::i64* keyTimes = columns.keyTime.data() + firstKey;
+	const fbx::KeyTimeBuffer keyTimeBuffer = std::make_shared<const std::vector<fbx::i64>>(keyTimes, keyTimes + realKeyCount);
+
+	for (fbx::AnimationCurve* curve : { posX, posY, posZ, rotX, rotY, rotZ })
+		curve->ShareKeyTimes(keyTimeBuffer);
+
+	// transform channels are converted in one batch straight into the curves values
+	float* const posValues[3] = { posX->getKeyValue(), posY->getKeyValue(), posZ->getKeyValue() };
+	float* const rotValues[3] = { rotX->getKeyValue(), rotY->getKeyValue(), rotZ->getKeyValue() };
+	cgiConvert.ConvertToFBX(columns, firstKey, static_cast<size_t>(realKeyCount), posValues, rotValues);
+
+	// processed camera node attribute values, from a calibrated rig or from a lens calibration table
+	const bool hasFocalLength = cgiConvert.HasFocalLength();
+	const bool hasFocusDistance = cgiConvert.HasFocusDistance();
+	if (hasFocalLength)
+	{
+		fieldOfViewCurve->ShareKeyTimes(keyTimeBuffer);
+		cgiConvert.ConvertFieldOfView(columns, firstKey, static_cast<size_t>(realKeyCount), fieldOfViewCurve->getKeyValue());
+	}
+	if (hasFocusDistance)
 	{
-		const auto& packet = cgiConvert.GetPacket(i);
-		fbx::OFBTime time(packet.timeCode.hours, packet.timeCode.minutes, packet.timeCode.seconds, packet.timeCode.frames, 0, fbx::OFBTimeMode::eCustom, fps);
+		focusDistanceCurve->ShareKeyTimes(keyTimeBuffer);
+		cgiConvert.ConvertFocusDistance(columns, firstKey, static_cast<size_t>(realKeyCount), focusDistanceCurve->getKeyValue());
+	}
 
-		// TRIM OPERATION
-		const double timeSec = time.GetSecondDouble();
-		if (hasTrimRegion)
+	// raw values, a curve per column is a copy of the column range
+	auto fn_setColumnKeys = [&keyTimeBuffer, firstKey, realKeyCount](fbx::AnimationCurve* curve, const std::vector<float>& column)
 		{
-			if (timeSec < startTime)
-				continue;
-			else if (timeSec > endTime)
-				break;
-		}
+			curve->ShareKeyTimes(keyTimeBuffer);
+			std::copy(begin(column) + firstKey, begin(column) + firstKey + realKeyCount, curve->getKeyValue());
+		};
 
-		fbx::FVector4 posXYZ, rotXYZ;
-		cgiConvert.ConvertToFBX(packet, posXYZ, rotXYZ);
+	fn_setColumnKeys(zoomCurve, columns.zoom);
+	fn_setColumnKeys(focusCurve, columns.focus);
+	if (cgiConvert.HasTStop())
+	{
+		// the iris curve of a calibration table carries T-stops
+		irisCurve->ShareKeyTimes(keyTimeBuffer);
+		cgiConvert.ConvertTStop(columns, firstKey, static_cast<size_t>(realKeyCount), irisCurve->getKeyValue());
+	}
+	else
+	{
+		fn_setColumnKeys(irisCurve, columns.iris);
+	}
+	fn_setColumnKeys(trackPosCurve, columns.trackPos);
 
-		posX->SetKey(realKeyCount, time, posXYZ.x);
-		posY->SetKey(realKeyCount, time, posXYZ.y);
-		posZ->SetKey(realKeyCount, time, posXYZ.z);
+	// integer columns are converted into value arrays in one pass, the arrays are moved into the curves
+	const size_t keyCount = static_cast<size_t>(realKeyCount);
+	std::vector<float> packetNumberValues(keyCount);
+	std::vector<float> tcHourValues(keyCount), tcMinuteValues(keyCount), tcSecondValues(keyCount), tcFrameValues(keyCount);
 
-		rotX->SetKey(realKeyCount, time, rotXYZ.x);
-		rotY->SetKey(realKeyCount, time, rotXYZ.y);
-		rotZ->SetKey(realKeyCount, time, rotXYZ.z);
+	const u32* packetNumbers = columns.packetNumber.data() + firstKey;
+	const timeCodeStruct* timeCodes = columns.timeCode.data() + firstKey;
+	for (size_t i = 0; i < keyCount; ++i)
+	{
+		packetNumberValues[i] = static_cast<float>(packetNumbers[i]);
+		tcHourValues[i] = static_cast<float>(timeCodes[i].hours);
+		tcMinuteValues[i] = static_cast<float>(timeCodes[i].minutes);
+		tcSecondValues[i] = static_cast<float>(timeCodes[i].seconds);
+		tcFrameValues[i] = static_cast<float>(timeCodes[i].frames);
+	}
 
-		// processed camera node attribute values
-		if (cgiConvert.IsCalibratedCGI())
+	auto fn_setConstKeys = [&keyTimeBuffer](fbx::AnimationCurve* curve, std::vector<float>& values) -> bool
 		{
-			fieldOfViewCurve->SetKey(realKeyCount, time, cgiConvert.ConvertFocalLength(packet));
-			focusDistanceCurve->SetKey(realKeyCount, time, cgiConvert.ConvertFocusDistance(packet));
-		}
+			if (!curve->SetKeys(keyTimeBuffer, std::move(values)))
+				return false;
+			curve->SetKeyConstFlags();
+			return true;
+		};
+
+	if (!fn_setConstKeys(packetNumberCurve, packetNumberValues)
+		|| !fn_setConstKeys(tcHourCurve, tcHourValues)
+		|| !fn_setConstKeys(tcMinuteCurve, tcMinuteValues)
+		|| !fn_setConstKeys(tcSecondCurve, tcSecondValues)
+		|| !fn_setConstKeys(tcFrameCurve, tcFrameValues))
+	{
+		return false;
+	}
+
+	const fbx::i64 rateKeyTime = 0;
+	const float rateValue = static_cast<float>(fps);
+	tcRateCurve->SetKeys(&rateKeyTime, &rateValue, 1);
+	tcRateCurve->SetKeyConstFlags();
+
+	// simplify curves when all keys are set
+	const CGIKeyReduction& reduction = cgiConvert.GetKeyReduction();
+	if (reduction.isEnabled)
+	{
+		// translation and focus distance tolerances are in cm, the curves are in the preset units
+		const float unitTolerance = GetCoordinateSystemUnitScale(cgiConvert.GetCoordinateSystem()) / 100.0f;
+
+		int numberOfRemovedKeys = 0;
+		for (fbx::AnimationCurve* curve : { posX, posY, posZ })
+			numberOfRemovedKeys += curve->ReduceKeys(reduction.translation * unitTolerance);
+		for (fbx::AnimationCurve* curve : { rotX, rotY, rotZ })
+			numberOfRemovedKeys += curve->ReduceKeys(reduction.rotation);
 
-		// raw values
-		zoomCurve->SetKey(realKeyCount, time, packet.zoom);
-		focusCurve->SetKey(realKeyCount, time, packet.focus);
-		irisCurve->SetKey(realKeyCount, time, packet.iris);
-		trackPosCurve->SetKey(realKeyCount, time, packet.spare.trackPos);
-		packetNumberCurve->SetKey(realKeyCount, time, static_cast<float>(packet.packetNumber));
+		if (hasFocalLength)
+			numberOfRemovedKeys += fieldOfViewCurve->ReduceKeys(reduction.focalLength);
+		if (hasFocusDistance)
+			numberOfRemovedKeys += focusDistanceCurve->ReduceKeys(reduction.focusDistance * unitTolerance);
 
-		tcHourCurve->SetKey(realKeyCount, time, static_cast<float>(packet.timeCode.hours));
-		tcMinuteCurve->SetKey(realKeyCount, time, static_cast<float>(packet.timeCode.minutes));
-		tcSecondCurve->SetKey(realKeyCount, time, static_cast<float>(packet.timeCode.seconds));
-		tcFrameCurve->SetKey(realKeyCount, time, static_cast<float>(packet.timeCode.frames));
+		for (fbx::AnimationCurve* curve : { zoomCurve, focusCurve, irisCurve })
+			numberOfRemovedKeys += curve->ReduceKeys(reduction.lens);
+		numberOfRemovedKeys += trackPosCurve->ReduceKeys(reduction.trackPos);
 
-		realKeyCount += 1;
+		for (fbx::AnimationCurve* curve : { packetNumberCurve, tcHourCurve, tcMinuteCurve, tcSecondCurve, tcFrameCurve })
+			numberOfRemovedKeys += curve->ReduceKeys(0.0);
+
+		if (isVerbose)
+			LogPrintf("Key reduction removed %d keys\n", numberOfRemovedKeys);
 	}
 	return true;
 }
 
+#ifdef __EMSCRIPTEN__
+constexpr const char* DEFAULT_TEMPLATE_FILENAME{ "assets/tdcamera2.fbx" };
+constexpr const char* DEFAULT_OUTPUT_FILENAME{ "TDCamera.fbx" };
+#else
+constexpr const char* DEFAULT_TEMPLATE_FILENAME{ "C:\\work\\technocrane\\tdcamera.fbx" };
+constexpr const char* DEFAULT_OUTPUT_FILENAME{ "c:\\work\\technocrane\\test-cgi.fbx" };
+#endif
+
 /**
- * Load CGI, trim it and save into fbx.
+ * Import the fbx template file, the parsed document is copied for every export.
  * 
- * \param buffer - cgi data
- * \param size size of cgi data
- * \return status of the operation
+ * \param templateDoc - output document with the template nodes
+ * \return true if the template is imported
  */
-EXTERN int TrimAndExportToFBX(uint8_t* buffer, size_t size, double frameRate, double startTimeSec, double endTimeSec, int isBinary, bool isVerbose=false) 
+bool ImportTemplateDocument(fbx::FBXDocument& templateDoc, const char* templateFilename, bool isVerbose)
 {
-	CGIConvert cgiConvert;
-	if (!cgiConvert.LoadPackets(buffer, size, static_cast<float>(frameRate))
-		|| cgiConvert.IsEmpty())
+	if (isVerbose)
+		printf("import a template file - %s\n", templateFilename);
+
+	fbx::Importer lImporter;
+	if (!lImporter.Initialize(templateFilename))
 	{
-		printf("ERROR: Faled to load cgi stream packets or stream has no packets!\n");
-		return -1;
+		printf("ERROR: failed to open a template file %s\n", templateFilename);
+		return false;
 	}
 
+	if (isVerbose)
+		std::cout << "Import" << std::endl;
+	lImporter.Import(templateDoc);
+	return true;
+}
+
+/**
+ * Name of an export file, ranges of a multi range export get the range number suffix.
+ */
+std::string GetOutputFilename(const std::string& outputFilename, size_t rangeIndex, size_t numberOfRanges)
+{
+	if (numberOfRanges <= 1)
+		return outputFilename;
+
+	const size_t dot = outputFilename.rfind('.');
+	const size_t separator = outputFilename.find_last_of("/\\");
+	const bool hasExtension = (dot != std::string::npos && (separator == std::string::npos || dot > separator));
+
+	const std::string suffix = "_" + std::to_string(rangeIndex + 1);
+	return (hasExtension) ? outputFilename.substr(0, dot) + suffix + outputFilename.substr(dot)
+		: outputFilename + suffix;
+}
+
+/**
+ * Save sorted packets [firstKey; lastKey) into fbx, made from a copy of the template document.
+ * 
+ * \param templateDoc - imported template, see ImportTemplateDocument
+ * \param cgiConvert - loaded cgi packets
+ * \return status of the operation
+ */
+int ExportKeyRangeToFBX(const fbx::FBXDocument& templateDoc, CGIConvert& cgiConvert, double frameRate, double startTimeSec, double endTimeSec,
+	size_t firstKey, size_t lastKey, const std::string& outputFilename, int isBinary, bool isVerbose)
+{
 	//
 	// write into fbx
 
-	fbx::FBXDocument doc;
-	fbx::Importer lImporter;
+	fbx::FBXDocument doc(templateDoc);
 
-#ifdef __EMSCRIPTEN__
-	constexpr const char* templateFilename{ "assets/tdcamera2.fbx" };
-#else
-	constexpr const char* templateFilename{ "C:\\work\\technocrane\\tdcamera.fbx" };
-#endif
 	if (isVerbose)
-		printf("import a template file - %s\n", templateFilename);
-	bool lSuccess = lImporter.Initialize(templateFilename);
+		LogPrintf("Parse\n");
+	// prepare scene data
+	doc.ParseConnections();
+	doc.ParseObjects();
+
+	// modify keyframes
+	if (isVerbose)
+		LogPrintf("Scene retrieve\n");
+	fbx::Scene scene;
+	scene.Retrieve(&doc);
 
-	if (lSuccess)
+	if (isVerbose)
+		LogPrintf("Prepare camera animation\n");
+	if (!PrepareCameraAnimation(scene, cgiConvert, firstKey, lastKey, frameRate, isVerbose))
 	{
 		if (isVerbose)
-			std::cout << "Import" << std::endl;
-		lImporter.Import(doc);
+			LogPrintf("Failed to prepare camera animation\n");
+		return -1;
+	}
 
-		if (isVerbose)
-			std::cout << "Parse" << std::endl;
-		// prepare scene data
-		doc.ParseConnections();
-		doc.ParseObjects();
+	if (isVerbose)
+		LogPrintf("Scene store\n");
+	scene.Store(&doc);
 
-		// modify keyframes
-		if (isVerbose)
-			std::cout << "Scene retrieve" << std::endl;
-		fbx::Scene scene;
-		scene.Retrieve(&doc);
+	// modify doc global information
+	const CGIDataCartesian& firstPacket = cgiConvert.GetPacket(0);
+	const CGIDataCartesian& lastPacket = cgiConvert.GetPacket(cgiConvert.GetNumberOfPackets() - 1);
+	
+	// the take spans whole timecode seconds around the packets, in the same real time as the keys
+	const CGIFrameRate timeCodeRate = CGIFrameRate::FromDouble(frameRate);
+	const int64_t firstFrame = TimeCodeToFrameCount(firstPacket.timeCode, timeCodeRate);
+	const int64_t lastFrame = TimeCodeToFrameCount(lastPacket.timeCode, timeCodeRate);
 
-		if (isVerbose)
-			std::cout << "Prepare camera animation" << std::endl;
-		if (!PrepareCameraAnimation(scene, cgiConvert, startTimeSec, endTimeSec, frameRate))
-		{
-			if (isVerbose)
-				std::cout << "Failed to prepare camera animation" << std::endl;
-			return -1;
-		}
+	timeCodeStruct firstSecond(firstPacket.timeCode);
+	firstSecond.frames = 0;
+	timeCodeStruct lastSecond(lastPacket.timeCode);
+	lastSecond.frames = 0;
 
-		if (isVerbose)
-			std::cout << "Scene store" << std::endl;
-		scene.Store(&doc);
+	const int64_t startFrame = std::min(TimeCodeToFrameCount(firstSecond, timeCodeRate), firstFrame);
+	const int64_t stopFrame = std::max(TimeCodeToFrameCount(lastSecond, timeCodeRate) + timeCodeRate.nominal, lastFrame + 1);
 
-		// modify doc global information
-		const CGIDataCartesian& firstPacket = cgiConvert.GetPacket(0);
-		const CGIDataCartesian& lastPacket = cgiConvert.GetPacket(cgiConvert.GetNumberOfPackets() - 1);
-		
-		fbx::OFBTime startTime(firstPacket.timeCode.hours, firstPacket.timeCode.minutes, firstPacket.timeCode.seconds, 0, 0, fbx::OFBTimeMode::eCustom, frameRate);
-		fbx::OFBTime stopTime(lastPacket.timeCode.hours, lastPacket.timeCode.minutes, lastPacket.timeCode.seconds + 1, 0, 0, fbx::OFBTimeMode::eCustom, frameRate);
+	fbx::OFBTime startTime(FrameCountToKeyTime(startFrame, timeCodeRate));
+	fbx::OFBTime stopTime(FrameCountToKeyTime(stopFrame, timeCodeRate));
 
-		if (startTimeSec > 0.0) startTime.SetSecondDouble(startTimeSec);
-		if (endTimeSec > 0.0) stopTime.SetSecondDouble(endTimeSec);
+	// trim times are timecode labels, see LabelSecondsToFrameCount
+	const bool dropFrame = firstPacket.timeCode.dropFrame != 0;
+	if (startTimeSec > 0.0) startTime = fbx::OFBTime(FrameCountToKeyTime(LabelSecondsToFrameCount(startTimeSec, timeCodeRate, dropFrame, false), timeCodeRate));
+	if (endTimeSec > 0.0) stopTime = fbx::OFBTime(FrameCountToKeyTime(LabelSecondsToFrameCount(endTimeSec, timeCodeRate, dropFrame, true), timeCodeRate));
 
-		doc.UpdateHeader();
-		doc.UpdateGlobalSettings(startTime.Get(), stopTime.Get(), frameRate);
-		doc.UpdateDefinitions();
-		doc.UpdateAnimationTakeTime(startTime.Get(), stopTime.Get());
+	// the scene frame rate is the rate of the keys
+	const double sceneFrameRate = (cgiConvert.GetResampling().IsEnabled()) ? cgiConvert.GetResampling().frameRate : frameRate;
 
-		// save to file
-		
+	doc.UpdateHeader();
+	doc.UpdateGlobalSettings(startTime.Get(), stopTime.Get(), sceneFrameRate);
+
+	// the file declares the axes and units the preset values are in
+	const CGIAxisSystem axes = GetCoordinateSystemAxes(cgiConvert.GetCoordinateSystem());
+	doc.UpdateAxisSystem(axes.upAxis, axes.upAxisSign, axes.frontAxis, axes.frontAxisSign, axes.coordAxis, axes.coordAxisSign,
+		GetCoordinateSystemUnitScaleFactor(cgiConvert.GetCoordinateSystem()));
+	doc.UpdateDefinitions();
+	doc.UpdateAnimationTakeTime(startTime.Get(), stopTime.Get());
+
+	// save to file
+	
 #ifdef __EMSCRIPTEN__
-		fbx::Exporter	lExporter;
+	fbx::Exporter	lExporter;
 
-		std::cout << "Writing TDCamera.fbx" << std::endl;
-		
-		lExporter.Initialize("", false);
-		lExporter.Export(doc);
+	LogPrintf("Writing %s\n", outputFilename.c_str());
+	
+	lExporter.Initialize("", false);
+	lExporter.Export(doc);
 
-		const std::string filename{ "TDCamera.fbx" };
-		const std::string mime_type{ "application/text/plain" };
+	const std::string mime_type{ "application/text/plain" };
 
-		printf("Ready to download!\n");
-		emscripten_browser_file::download(filename, mime_type, lExporter.GetStreamBuffer());
+	LogPrintf("Ready to download!\n");
+	emscripten_browser_file::download(outputFilename, mime_type, lExporter.GetStreamBuffer());
 #else
-		fbx::Exporter	lExporter;
+	fbx::Exporter	lExporter;
 
-		constexpr const char* outputFilename{ "c:\\work\\technocrane\\test-cgi.fbx" };
-		std::cout << "Writing " << outputFilename << std::endl;
+	LogPrintf("Writing %s\n", outputFilename.c_str());
 
-		lExporter.Initialize(outputFilename, isBinary > 0);
-		lExporter.Export(doc);
+	lExporter.Initialize(outputFilename.c_str(), isBinary > 0);
+	lExporter.Export(doc);
 #endif
-	}
 	
 	return 1;
 }
 
-
 /**
- * main entry point.
- *  Arguments <filename to read> <frameRate> <startTime> <endTime>
- *
- * \return
+ * Trim loaded packets by a list of ranges and save every range into own fbx.
+ *  The range bounds are found in one merge over the sorted packets
+ * 
+ * \param templateDoc - imported template, see ImportTemplateDocument
+ * \param cgiConvert - loaded cgi packets
+ * \param trimRanges - pairs of start / end time in seconds, end time 0 means the whole recording,
+ *  seconds are timecode labels hh * 3600 + mm * 60 + ss, see LabelSecondsToFrameCount
+ * \param outputFilename - fbx file to write, ranges of a multi range export get the range number suffix
+ * \return number of exported ranges or -1 if none of them is exported
  */
-int main(int argc, char* argv[]) {
-	printf("Welcome To A Technocrane Trimmer!\n");
+int ExportRangesToFBX(const fbx::FBXDocument& templateDoc, CGIConvert& cgiConvert, double frameRate, const std::vector<std::pair<double, double>>& trimRanges,
+	const std::string& outputFilename, int isBinary, bool isVerbose)
+{
+	if (trimRanges.empty())
+		return -1;
 
-#ifndef __EMSCRIPTEN__
+	cgiConvert.BuildColumns(frameRate);
+	const CGIPacketColumns& columns = cgiConvert.GetColumns();
 
-	if (argc < 5)
+	std::vector<std::pair<size_t, size_t>> keyRanges;
+	columns.FindTimeRanges(trimRanges, keyRanges);
+
+	int numberOfExported = 0;
+	for (size_t i = 0; i < trimRanges.size(); ++i)
 	{
-		printf("Wrong number of arguments, please provide\n");
-		printf(" <filename to read> <frameRate> <startTime> <endTime>\n");
-		return -1;
+		const double startTimeSec = trimRanges[i].first;
+		const double endTimeSec = trimRanges[i].second;
+
+		// no trim region, export all packets
+		if (endTimeSec <= 0.0)
+			keyRanges[i] = std::make_pair(static_cast<size_t>(0), columns.Count());
+
+		if (ExportKeyRangeToFBX(templateDoc, cgiConvert, frameRate, startTimeSec, endTimeSec, keyRanges[i].first, keyRanges[i].second,
+			GetOutputFilename(outputFilename, i, trimRanges.size()), isBinary, isVerbose) > 0)
+		{
+			numberOfExported += 1;
+		}
 	}
 
-	const char* fname{ argv[1] };
-	std::ifstream fstream(fname, std::ios::binary | std::ios::ate);
-	std::streamsize size = fstream.tellg();
+	return (numberOfExported > 0) ? numberOfExported : -1;
+}
 
-	if (size <= 0)
-	{
-		printf("Failed to read the file!\n");
+/**
+ * Trim loaded packets by a list of ranges and save every range into own fbx,
+ *  the default template and output file are used
+ * 
+ * \return number of exported ranges or -1 if none of them is exported
+ */
+int ExportRangesToFBX(CGIConvert& cgiConvert, double frameRate, const std::vector<std::pair<double, double>>& trimRanges, int isBinary, bool isVerbose)
+{
+	fbx::FBXDocument templateDoc;
+	if (!ImportTemplateDocument(templateDoc, DEFAULT_TEMPLATE_FILENAME, isVerbose))
 		return -1;
-	}
 
-	fstream.seekg(0, std::ios::beg);
+	return ExportRangesToFBX(templateDoc, cgiConvert, frameRate, trimRanges, DEFAULT_OUTPUT_FILENAME, isBinary, isVerbose);
+}
+
+/**
+ * Trim loaded packets and save into fbx.
+ * 
+ * \param cgiConvert - loaded cgi packets
+ * \return status of the operation
+ */
+int ExportPacketsToFBX(CGIConvert& cgiConvert, double frameRate, double startTimeSec, double endTimeSec, int isBinary, bool isVerbose)
+{
+	const std::vector<std::pair<double, double>> trimRanges(1, std::make_pair(startTimeSec, endTimeSec));
+	return ExportRangesToFBX(cgiConvert, frameRate, trimRanges, isBinary, isVerbose);
+}
+
+/**
+ * Convert a flat array of start / end time pairs into trim ranges.
+ */
+std::vector<std::pair<double, double>> MakeTrimRanges(const double* rangeTimes, int numberOfRanges)
+{
+	std::vector<std::pair<double, double>> trimRanges;
+	for (int i = 0; i < numberOfRanges; ++i)
+		trimRanges.emplace_back(rangeTimes[2 * i], rangeTimes[2 * i + 1]);
+	return trimRanges;
+}
 
-	std::vector<uint8_t> buffer(static_cast<size_t>(size)+1, 0);
-	if (fstream.read((char*)buffer.data(), size))
+/**
+ * Load CGI, trim it and save into fbx.
+ * 
+ * \param buffer - cgi data
+ * \param size size of cgi data
+ * \return status of the operation
+ */
+EXTERN int TrimAndExportToFBX(const uint8_t* buffer, size_t size, double frameRate, double startTimeSec, double endTimeSec, int isBinary, bool isVerbose=false) 
+{
+	CGIConvert cgiConvert;
+	if (!cgiConvert.LoadPackets(buffer, size, static_cast<float>(frameRate))
+		|| cgiConvert.IsEmpty())
 	{
-		double frameRate, startTime, endTime;
-		sscanf_s(argv[2], "%lf", &frameRate);
-		sscanf_s(argv[3], "%lf", &startTime);
-		sscanf_s(argv[4], "%lf", &endTime);
+		printf("ERROR: Faled to load cgi stream packets or stream has no packets!\n");
+		return -1;
+	}
 
-		PrintCGIInfo(buffer.data(), static_cast<size_t>(size), frameRate);
+	return ExportPacketsToFBX(cgiConvert, frameRate, startTimeSec, endTimeSec, isBinary, isVerbose);
+}
 
-		TrimAndExportToFBX(buffer.data(), static_cast<size_t>(size), frameRate, startTime, endTime, false);
-	}
+/**
+ * Load CGI once and save every trim range into own fbx.
+ * 
+ * \param rangeTimes - start / end time pairs in seconds, 2 * numberOfRanges values
+ * \return number of exported ranges or -1 if none of them is exported
+ */
+EXTERN int TrimRangesAndExportToFBX(const uint8_t* buffer, size_t size, double frameRate, const double* rangeTimes, int numberOfRanges, int isBinary, bool isVerbose = false)
+{
+	CGIConvert cgiConvert;
+	if (!cgiConvert.LoadPackets(buffer, size, static_cast<float>(frameRate))
+		|| cgiConvert.IsEmpty())
+	{
+		printf("ERROR: Faled to load cgi stream packets or stream has no packets!\n");
+		return -1;
+	}
+
+	return ExportRangesToFBX(cgiConvert, frameRate, MakeTrimRanges(rangeTimes, numberOfRanges), isBinary, isVerbose);
+}
+
+/**
+ * Load CGI once into a session, the session is used for any number of info and trim calls.
+ *  The buffer is copied into the session, so it can be released right after the call
+ * 
+ * \param buffer - cgi data
+ * \param size size of cgi data
+ * \param frameRate - a given frame rate of packets in the stream
+ * \return a session handle or nullptr if the stream has no packets, close it with CGISessionClose
+ */
+EXTERN CGISession* CGISessionOpen(const uint8_t* buffer, size_t size, double frameRate)
+{
+	CGISession* session = new CGISession();
+	if (!session->Open(buffer, size, frameRate))
+	{
+		printf("ERROR: Faled to load cgi stream packets or stream has no packets!\n");
+		delete session;
+		return nullptr;
+	}
+	return session;
+}
+
+/**
+ * Print to console information about packets of the session, like start / stop timecodes and data gaps.
+ * 
+ * \return status of a print, 0 - successful
+ */
+EXTERN int CGISessionPrintInfo(CGISession* session, bool printTimecodes = false)
+{
+	if (session == nullptr || !session->IsOpen())
+		return -1;
+
+	return PrintPacketsInfo(session->GetConvert(), session->GetFrameRate(), printTimecodes);
+}
+
+/**
+ * Statistics of the session packets as a json text, see CGIStatistics.
+ *  The text is owned by the session and valid until the session is closed
+ * 
+ * \return json text, nullptr for a closed session
+ */
+EXTERN const char* CGISessionGetStatistics(CGISession* session)
+{
+	if (session == nullptr || !session->IsOpen())
+		return nullptr;
+
+	return session->GetStatisticsJSON().c_str();
+}
+
+/**
+ * Set the output key frame grid of session exports.
+ * 
+ * \param frameRate - output frame rate, 0 - a key per packet
+ * \param method - 0 nearest, 1 linear, 2 cubic interpolation
+ * \return 0 - successful
+ */
+EXTERN int CGISessionSetResampling(CGISession* session, double frameRate, int method)
+{
+	if (session == nullptr || !session->IsOpen() || method < 0 || method > static_cast<int>(CGIResampleMethod::Cubic))
+		return -1;
+
+	CGIResampling resampling;
+	resampling.frameRate = frameRate;
+	resampling.method = static_cast<CGIResampleMethod>(method);
+	session->GetConvert().SetResampling(resampling);
+	return 0;
+}
+
+/**
+ * Set the coordinate system of session exports.
+ * 
+ * \param coordinateSystem - 0 td, 1 maya, 2 houdini, 3 unreal, 4 unity (see CGICoordinateSystem)
+ * \return 0 - successful
+ */
+EXTERN int CGISessionSetCoordinateSystem(CGISession* session, int coordinateSystem)
+{
+	if (session == nullptr || !session->IsOpen() || coordinateSystem < 0 || coordinateSystem >= static_cast<int>(CGICoordinateSystem::Count))
+		return -1;
+
+	session->GetConvert().SetCoordinateSystem(static_cast<CGICoordinateSystem>(coordinateSystem));
+	return 0;
+}
+
+/**
+ * Set the lens calibration of session exports, used for packets of an uncalibrated rig.
+ * 
+ * \param calibrationText - lens calibration table (see CGILensCalibration), nullptr or empty to use only the chip size
+ * \param chipWidth - chip width in mm, 0 - the FieldOfView curve gets the focal length
+ * \param chipHeight - chip height in mm
+ * \return 0 - successful
+ */
+EXTERN int CGISessionSetLensCalibration(CGISession* session, const char* calibrationText, double chipWidth, double chipHeight)
+{
+	if (session == nullptr || !session->IsOpen())
+		return -1;
+
+	CGILensCalibration calibration;
+	if (calibrationText != nullptr && calibrationText[0] != 0 && !calibration.Parse(calibrationText))
+		return -1;
+
+	calibration.chipWidth = static_cast<float>(chipWidth);
+	calibration.chipHeight = static_cast<float>(chipHeight);
+	session->GetConvert().SetLensCalibration(calibration);
+	return 0;
+}
+
+/**
+ * Set the low-pass filter of session exports, a cutoff frequency per channel group (see CGIFiltering).
+ * 
+ * \param translationCutoff - cutoff of x, y, z in Hz, 0 - not filtered
+ * \param rotationCutoff - cutoff of pan, tilt, roll in Hz, 0 - not filtered
+ * \param lensCutoff - cutoff of zoom, focus, iris in Hz, 0 - not filtered
+ * \return 0 - successful
+ */
+EXTERN int CGISessionSetFiltering(CGISession* session, double translationCutoff, double rotationCutoff, double lensCutoff)
+{
+	if (session == nullptr || !session->IsOpen() || translationCutoff < 0.0 || rotationCutoff < 0.0 || lensCutoff < 0.0)
+		return -1;
+
+	CGIFiltering filtering;
+	filtering.translation = static_cast<float>(translationCutoff);
+	filtering.rotation = static_cast<float>(rotationCutoff);
+	filtering.lens = static_cast<float>(lensCutoff);
+	filtering.isEnabled = translationCutoff > 0.0 || rotationCutoff > 0.0 || lensCutoff > 0.0;
+	session->GetConvert().SetFiltering(filtering);
+	return 0;
+}
+
+/**
+ * Turn on the key reduction of session exports.
+ * 
+ * \param toleranceScale - scale of the default tolerances (see CGIKeyReduction), 0 turns the reduction off
+ * \return 0 - successful
+ */
+EXTERN int CGISessionSetKeyReduction(CGISession* session, double toleranceScale)
+{
+	if (session == nullptr || !session->IsOpen())
+		return -1;
+
+	CGIKeyReduction reduction;
+	reduction.isEnabled = toleranceScale > 0.0;
+	reduction.Scale(static_cast<float>(toleranceScale));
+	session->GetConvert().SetKeyReduction(reduction);
+	return 0;
+}
+
+/**
+ * Trim packets of the session and save into fbx, packets are not loaded again.
+ * 
+ * \return status of the operation
+ */
+EXTERN int CGISessionTrimAndExport(CGISession* session, double startTimeSec, double endTimeSec, int isBinary, bool isVerbose = false)
+{
+	if (session == nullptr || !session->IsOpen())
+	{
+		printf("ERROR: cgi session is not opened!\n");
+		return -1;
+	}
+
+	return ExportPacketsToFBX(session->GetConvert(), session->GetFrameRate(), startTimeSec, endTimeSec, isBinary, isVerbose);
+}
+
+/**
+ * Save every trim range of the session packets into own fbx.
+ * 
+ * \param rangeTimes - start / end time pairs in seconds, 2 * numberOfRanges values
+ * \return number of exported ranges or -1 if none of them is exported
+ */
+EXTERN int CGISessionTrimRangesAndExport(CGISession* session, const double* rangeTimes, int numberOfRanges, int isBinary, bool isVerbose = false)
+{
+	if (session == nullptr || !session->IsOpen())
+	{
+		printf("ERROR: cgi session is not opened!\n");
+		return -1;
+	}
+
+	return ExportRangesToFBX(session->GetConvert(), session->GetFrameRate(), MakeTrimRanges(rangeTimes, numberOfRanges), isBinary, isVerbose);
+}
+
+/**
+ * Release the session memory.
+ */
+EXTERN void CGISessionClose(CGISession* session)
+{
+	delete session;
+}
+
+#ifndef __EMSCRIPTEN__
+/**
+ * Packet filter of the trim ranges for a load by chunks, the filter runs for every packet of the stream.
+ *  With the low-pass filter the ranges are extended by its context, a packet per frame at least
+ * 
+ * \param trimRanges - pairs of start / end time in seconds, see LabelSecondsToFrameCount
+ * \return an empty filter when a range is the whole recording
+ */
+CGIConvert::PacketFilter MakeTrimRangesFilter(double frameRate, const std::vector<std::pair<double, double>>& trimRanges, const CGIFiltering& filtering)
+{
+	bool hasTrimRegion = !trimRanges.empty();
+	for (const auto& trimRange : trimRanges)
+		hasTrimRegion = hasTrimRegion && (trimRange.second > 0.0);
+
+	if (!hasTrimRegion)
+		return CGIConvert::PacketFilter();
+
+	// trim ranges as timecode frame count bounds,
+	//  the drop frame flag comes with a packet, so there are bounds for both label countings
+	const CGIFrameRate timeCodeRate = CGIFrameRate::FromDouble(frameRate);
+	const int64_t filterContextFrames = static_cast<int64_t>(GetFilterContextPackets(filtering));
+	std::vector<std::pair<int64_t, int64_t>> frameRanges[2];
+	for (int dropFrame = 0; dropFrame < 2; ++dropFrame)
+	{
+		for (const auto& trimRange : trimRanges)
+		{
+			frameRanges[dropFrame].emplace_back(LabelSecondsToFrameCount(trimRange.first, timeCodeRate, dropFrame != 0, false) - filterContextFrames,
+				LabelSecondsToFrameCount(trimRange.second, timeCodeRate, dropFrame != 0, true) + filterContextFrames);
+		}
+	}
+
+	return [timeCodeRate, frameRanges](const CGIDataCartesian& packet) -> bool
+		{
+			const int64_t frameIndex = TimeCodeToFrameCount(packet.timeCode, timeCodeRate);
+			for (const auto& frameRange : frameRanges[(packet.timeCode.dropFrame) ? 1 : 0])
+			{
+				if (frameIndex >= frameRange.first && frameIndex <= frameRange.second)
+					return true;
+			}
+			return false;
+		};
+}
+
+/**
+ * Read CGI file by chunks, keep only packets of the trim ranges and save every range into fbx.
+ *  Memory usage doesn't depend on the file size, only on the trim ranges
+ * 
+ * \param templateDoc - imported template, see ImportTemplateDocument
+ * \param filename - cgi file to read
+ * \param chunkSize - size of a read chunk in bytes
+ * \param trimRanges - pairs of start / end time in seconds
+ * \param coordinateSystem - coordinate system preset of the export target
+ * \param lensCalibration - lens calibration table and chip size of an uncalibrated rig
+ * \param filtering - low-pass filter of the channels noise
+ * \param resampling - output key frame grid
+ * \param keyReduction - tolerances of the exported curves simplification
+ * \param outputFilename - fbx file to write
+ * \return status of the operation
+ */
+int StreamTrimAndExportToFBX(const fbx::FBXDocument& templateDoc, const char* filename, size_t chunkSize, double frameRate, const std::vector<std::pair<double, double>>& trimRanges,
+	const CGICoordinateSystem coordinateSystem, const CGILensCalibration& lensCalibration, const CGIFiltering& filtering, const CGIResampling& resampling, const CGIKeyReduction& keyReduction, const std::string& outputFilename, int isBinary, bool isVerbose = false)
+{
+	std::ifstream fstream(filename, std::ios::binary);
+	if (!fstream.is_open())
+	{
+		printf("Failed to read the file!\n");
+		return -1;
+	}
+
+	CGIConvert cgiConvert;
+	cgiConvert.SetCoordinateSystem(coordinateSystem);
+	cgiConvert.SetLensCalibration(lensCalibration);
+	cgiConvert.SetFiltering(filtering);
+	cgiConvert.SetResampling(resampling);
+	cgiConvert.SetKeyReduction(keyReduction);
+	const CGIConvert::PacketFilter trimFilter = MakeTrimRangesFilter(frameRate, trimRanges, filtering);
+	if (!cgiConvert.LoadPacketsFromStream(fstream, static_cast<float>(frameRate), chunkSize, trimFilter)
+		|| cgiConvert.IsEmpty())
+	{
+		printf("ERROR: Faled to load cgi stream packets or stream has no packets in the range!\n");
+		return -1;
+	}
+
+	// stream packets come in the file order, so the statistics pass runs after the trim
+	if (trimFilter)
+		printf("== Trim ranges statistics, the rest of the recording is not loaded ==\n");
+	PrintPacketsInfo(cgiConvert, frameRate, false);
+
+	return ExportRangesToFBX(templateDoc, cgiConvert, frameRate, trimRanges, outputFilename, isBinary, isVerbose);
+}
+
+/**
+ * Keep only sorted packets between the first and the last packet of all trim ranges and the low-pass filter context around them.
+ *  A range of the whole recording or a range without packets (its error message refers to neighbour packets)
+ *  keeps all packets
+ */
+void KeepTrimRangesPackets(CGIConvert& cgiConvert, double frameRate, const std::vector<std::pair<double, double>>& trimRanges)
+{
+	size_t hullFirst = static_cast<size_t>(cgiConvert.GetNumberOfPackets());
+	size_t hullLast = 0;
+
+	for (const auto& trimRange : trimRanges)
+	{
+		if (trimRange.second <= 0.0)
+			return;
+
+		size_t firstKey = 0, lastKey = 0;
+		cgiConvert.FindTimeRange(frameRate, trimRange.first, trimRange.second, firstKey, lastKey);
+		if (firstKey >= lastKey)
+			return;
+
+		hullFirst = std::min(hullFirst, firstKey);
+		hullLast = std::max(hullLast, lastKey);
+	}
+
+	// the low-pass filter reads packets around the ranges
+	const size_t context = GetFilterContextPackets(cgiConvert.GetFiltering());
+	hullFirst = (hullFirst > context) ? hullFirst - context : 0;
+	hullLast = std::min(hullLast + context, static_cast<size_t>(cgiConvert.GetNumberOfPackets()));
+
+	if (hullFirst < hullLast)
+		cgiConvert.KeepSortedPackets(hullFirst, hullLast);
+}
+
+/**
+ * Save statistics of a recording into a json file, see GetStatisticsJSON
+ */
+bool WriteStatisticsJSON(const char* filename, const CGIStatistics& statistics, double frameRate)
+{
+	FILE* f = nullptr;
+	if (fopen_s(&f, filename, "w") != 0 || f == nullptr)
+		return false;
+
+	const std::string json = GetStatisticsJSON(statistics, frameRate);
+	const bool status = fwrite(json.data(), sizeof(char), json.size(), f) == json.size();
+	fclose(f);
+	return status;
+}
+
+/**
+ * Load a memory mapped recording with the help of its sidecar index (see CGIRecordingIndex).
+ *  With a valid index the packets are not validated, sorted and scanned for the statistics again,
+ *  and only packets of the trim ranges are kept, so the rest of the file is never read.
+ *  Otherwise the recording is loaded as usual and a new index is written next to it,
+ *  an index is written only for binary recordings viewed in place
+ * 
+ * \param statistics - statistics of all recording packets
+ * \return false if the recording has no packets
+ */
+bool LoadRecordingWithIndex(const MemoryMappedFile& file, const char* filename, double frameRate,
+	const std::vector<std::pair<double, double>>& trimRanges, CGIConvert& cgiConvert, CGIStatistics& statistics, bool isVerbose)
+{
+	const std::string indexFilename = GetRecordingIndexFilename(filename);
+
+	CGIRecordingIndex index;
+	if (ReadRecordingIndex(indexFilename.c_str(), index)
+		&& IsRecordingIndexValid(index, file.GetData(), file.GetSize(), frameRate)
+		&& cgiConvert.LoadSortedPackets(file.GetData(), file.GetSize(), index.sortedPackets, index.inputOrder)
+		&& !cgiConvert.IsEmpty())
+	{
+		if (isVerbose)
+		{
+			LogPrintf("Loaded packets - %d, sorted by the index %s\n", cgiConvert.GetNumberOfPackets(), indexFilename.c_str());
+			PrintStatistics(index.statistics, frameRate);
+		}
+
+		statistics = index.statistics;
+		KeepTrimRangesPackets(cgiConvert, frameRate, trimRanges);
+		return true;
+	}
+
+	if (!cgiConvert.LoadPackets(file.GetData(), file.GetSize(), static_cast<float>(frameRate))
+		|| cgiConvert.IsEmpty())
+	{
+		return false;
+	}
+
+	if (isVerbose)
+	{
+		PrintPacketsInfo(cgiConvert, frameRate, false, index.statistics);
+	}
+	else
+	{
+		cgiConvert.BuildColumns(frameRate);
+		ComputeStatistics(cgiConvert.GetColumns(), index.statistics);
+	}
+
+	// the index refers to packets in the file order
+	if (cgiConvert.IsViewingInput() && cgiConvert.GetNumberOfInputPackets() <= UINT32_MAX)
+	{
+		index.fileSize = file.GetSize();
+		index.fileHash = ComputeRecordingHash(file.GetData(), file.GetSize());
+		index.frameRate = frameRate;
+		index.numberOfPackets = cgiConvert.GetNumberOfInputPackets();
+		index.inputOrder = cgiConvert.GetInputOrder();
+
+		const std::vector<size_t>& sortedPackets = cgiConvert.GetSortedPacketIndices();
+		index.sortedPackets.assign(begin(sortedPackets), end(sortedPackets));
+
+		if (WriteRecordingIndex(indexFilename.c_str(), index))
+		{
+			if (isVerbose)
+				LogPrintf("Writing index %s\n", indexFilename.c_str());
+		}
+		else
+		{
+			LogPrintf("Failed to write the index %s\n", indexFilename.c_str());
+		}
+	}
+
+	statistics = std::move(index.statistics);
+	return true;
+}
+
+/**
+ * Convert many recordings concurrently.
+ *  Every worker thread takes the next recording from the list, loads it and exports it with a copy
+ *  of the once imported template. A recording is processed serially on its worker and its log is
+ *  printed when the recording is finished, so logs of concurrent recordings don't interleave
+ * 
+ * \param jobs - recordings with their frame rates, trim ranges and output files
+ * \param templateDoc - imported template, see ImportTemplateDocument
+ * \param numberOfThreads - number of worker threads
+ * \param useIndex - load recordings with their sidecar index, see LoadRecordingWithIndex
+ * \param coordinateSystem - coordinate system preset of the export target
+ * \param lensCalibration - lens calibration table and chip size of an uncalibrated rig
+ * \param filtering - low-pass filter of the channels noise
+ * \param resampling - output key frame grid of all recordings
+ * \param keyReduction - tolerances of the exported curves simplification
+ * \return number of failed recordings
+ */
+int RunBatch(const std::vector<BatchJob>& jobs, const fbx::FBXDocument& templateDoc, size_t numberOfThreads, int isBinary, bool useIndex,
+	const CGICoordinateSystem coordinateSystem, const CGILensCalibration& lensCalibration, const CGIFiltering& filtering, const CGIResampling& resampling, const CGIKeyReduction& keyReduction)
+{
+	struct BatchResult
+	{
+		int		status{ -1 };
+		int		numberOfPackets{ 0 };
+		double	loadMs{ 0.0 };
+		double	exportMs{ 0.0 };
+	};
+
+	auto fn_getMs = [](const std::chrono::steady_clock::time_point& from, const std::chrono::steady_clock::time_point& to) -> double
+		{
+			return std::chrono::duration<double, std::milli>(to - from).count();
+		};
+
+	std::vector<BatchResult> results(jobs.size());
+	std::atomic<size_t> nextJob(0);
+
+	// a job runs serially on its worker thread, its log is printed at once when the job is finished
+	auto fn_runJob = [&](const BatchJob& job, BatchResult& result)
+		{
+			if (job.isDuplicateOutput)
+			{
+				LogPrintf("ERROR: %s is the output of a previous job\n", job.outputFilename.c_str());
+				return;
+			}
+
+			const auto loadStart = std::chrono::steady_clock::now();
+
+			MemoryMappedFile file;
+			CGIConvert cgiConvert;
+			cgiConvert.SetCoordinateSystem(coordinateSystem);
+			cgiConvert.SetLensCalibration(lensCalibration);
+			cgiConvert.SetFiltering(filtering);
+			cgiConvert.SetResampling(resampling);
+			cgiConvert.SetKeyReduction(keyReduction);
+			CGIStatistics statistics;
+			const bool isLoaded = file.Open(job.inputFilename.c_str())
+				&& ((useIndex) ? LoadRecordingWithIndex(file, job.inputFilename.c_str(), job.frameRate, job.trimRanges, cgiConvert, statistics, false)
+					: cgiConvert.LoadPackets(file.GetData(), file.GetSize(), static_cast<float>(job.frameRate), MakeTrimRangesFilter(job.frameRate, job.trimRanges, filtering)))
+				&& !cgiConvert.IsEmpty();
+
+			if (isLoaded)
+				cgiConvert.BuildColumns(job.frameRate);
+
+			const auto exportStart = std::chrono::steady_clock::now();
+			result.loadMs = fn_getMs(loadStart, exportStart);
+
+			if (!isLoaded)
+			{
+				LogPrintf("ERROR: Failed to load %s\n", job.inputFilename.c_str());
+				return;
+			}
+
+			result.numberOfPackets = cgiConvert.GetNumberOfPackets();
+			result.status = ExportRangesToFBX(templateDoc, cgiConvert, job.frameRate, job.trimRanges, job.outputFilename, isBinary, false);
+			result.exportMs = fn_getMs(exportStart, std::chrono::steady_clock::now());
+		};
+
+	std::mutex logMutex;
+
+	auto fn_worker = [&]()
+		{
+			// the workers already use all cores, nested ParallelFor passes of a job would oversubscribe them
+			std::unique_ptr<ParallelForSerialScope> serialScope((numberOfThreads > 1) ? new ParallelForSerialScope() : nullptr);
+
+			for (size_t i = nextJob++; i < jobs.size(); i = nextJob++)
+			{
+				std::string log;
+				{
+					CGILogScope logScope(log);
+					fn_runJob(jobs[i], results[i]);
+				}
+
+				std::lock_guard<std::mutex> lock(logMutex);
+				fputs(log.c_str(), stdout);
+			}
+		};
+
+	const auto batchStart = std::chrono::steady_clock::now();
+
+	numberOfThreads = std::max(static_cast<size_t>(1), std::min(numberOfThreads, jobs.size()));
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < numberOfThreads; ++i)
+		workers.emplace_back(fn_worker);
+
+	fn_worker();
+	for (auto& worker : workers)
+		worker.join();
+
+	const double batchMs = fn_getMs(batchStart, std::chrono::steady_clock::now());
+
+	// report
+	int numberOfFailed = 0;
+	printf("== Batch ==\n");
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const BatchResult& result = results[i];
+		if (result.status > 0)
+		{
+			printf("%s - OK, packets %d, ranges %d, load %.1f ms, export %.1f ms\n", jobs[i].inputFilename.c_str(),
+				result.numberOfPackets, result.status, result.loadMs, result.exportMs);
+		}
+		else
+		{
+			printf("%s - FAILED, packets %d, load %.1f ms, export %.1f ms\n", jobs[i].inputFilename.c_str(),
+				result.numberOfPackets, result.loadMs, result.exportMs);
+			numberOfFailed += 1;
+		}
+	}
+	printf("Converted %d of %d recordings in %.1f ms, %d threads\n", static_cast<int>(jobs.size()) - numberOfFailed,
+		static_cast<int>(jobs.size()), batchMs, static_cast<int>(numberOfThreads));
+	printf("==========\n");
+
+	return numberOfFailed;
+}
+
+/**
+ * Capture a live stream and export parts of the rolling window on a console command.
+ *  Commands
+ *   last <seconds> - export the last seconds of the stream
+ *   from <hh:mm:ss:ff> - export from a timecode up to now
+ *   info - print the window span and the capture counters
+ *   quit - stop the capture
+ *  Every export is saved into own fbx file with a number suffix
+ * 
+ * \param address - live source address, see CGILiveSource
+ * \param windowSeconds - length of the kept rolling window
+ * \param coordinateSystem - coordinate system preset of the export target
+ * \param lensCalibration - lens calibration table and chip size of an uncalibrated rig
+ * \param filtering - low-pass filter of the channels noise
+ * \param resampling - output key frame grid of exports
+ * \param keyReduction - tolerances of the exported curves simplification
+ * \return number of exported files, -1 when the source can't be opened
+ */
+int RunLiveCapture(const fbx::FBXDocument& templateDoc, const char* address, double frameRate, double windowSeconds,
+	const CGICoordinateSystem coordinateSystem, const CGILensCalibration& lensCalibration, const CGIFiltering& filtering, const CGIResampling& resampling, const CGIKeyReduction& keyReduction, const std::string& outputFilename, int isBinary)
+{
+	CGILiveCapture capture;
+	if (!capture.Start(address, frameRate, windowSeconds))
+		return -1;
+
+	printf("Capturing %s, commands: last <seconds> | from <hh:mm:ss:ff> | info | quit\n", address);
+
+	int numberOfExports = 0;
+	std::vector<CGIDataCartesian> packets;
+	std::string line;
+
+	while (capture.IsRunning() && std::getline(std::cin, line))
+	{
+		double seconds = 0.0;
+		unsigned int hours = 0, minutes = 0, secs = 0, frames = 0;
+
+		if (sscanf_s(line.c_str(), "last %lf", &seconds) == 1)
+		{
+			capture.CopyLastSeconds(seconds, packets);
+		}
+		else if (sscanf_s(line.c_str(), "from %u:%u:%u:%u", &hours, &minutes, &secs, &frames) == 4)
+		{
+			timeCodeStruct timeCode;
+			memset(&timeCode, 0, sizeof(timeCodeStruct));
+			timeCode.hours = hours;
+			timeCode.minutes = minutes;
+			timeCode.seconds = secs;
+			timeCode.frames = frames;
+
+			capture.CopyWindow(CGILiveCapture::GetKeySecond(timeCode, frameRate), 0.0, packets);
+		}
+		else if (line == "info")
+		{
+			double firstTime = 0.0, lastTime = 0.0;
+			if (capture.GetWindowSpan(firstTime, lastTime))
+				printf("Window %zu packets, %.2f seconds\n", capture.GetWindowSize(), lastTime - firstTime);
+			printf("Received packets %zu, dropped packets %zu\n", capture.GetNumberOfReceivedPackets(), capture.GetNumberOfDroppedPackets());
+			continue;
+		}
+		else if (line == "quit")
+		{
+			break;
+		}
+		else
+		{
+			printf("Unknown command %s\n", line.c_str());
+			continue;
+		}
+
+		if (packets.empty())
+		{
+			printf("ERROR: no captured packets in the range!\n");
+			continue;
+		}
+
+		// the window copy is in the timecode order already, the load is a view over it without sorting
+		CGIConvert cgiConvert;
+		cgiConvert.SetCoordinateSystem(coordinateSystem);
+		cgiConvert.SetLensCalibration(lensCalibration);
+		cgiConvert.SetFiltering(filtering);
+		cgiConvert.SetResampling(resampling);
+		cgiConvert.SetKeyReduction(keyReduction);
+		cgiConvert.LoadPackets(reinterpret_cast<const uint8_t*>(packets.data()), packets.size() * sizeof(CGIDataCartesian), static_cast<float>(frameRate));
+
+		const std::vector<std::pair<double, double>> wholeRange(1, std::make_pair(0.0, 0.0));
+		const std::string exportFilename = GetOutputFilename(outputFilename, static_cast<size_t>(numberOfExports), SIZE_MAX);
+
+		if (ExportRangesToFBX(templateDoc, cgiConvert, frameRate, wholeRange, exportFilename, isBinary, false) > 0)
+			numberOfExports += 1;
+	}
+
+	capture.Stop();
+	return numberOfExports;
+}
+#endif
+
+
+/**
+ * main entry point.
+ *  Arguments <filename to read (.cgi, .gz or .zip)> <frameRate> <startTime> <endTime> [options]
+ *         or -batch <directory or manifest file> [options]
+ *         or -capture <live address> [options]
+ *         or -replay <filename to read> <live address> [-fps <frameRate>]
+ *  Options
+ *   -stream [chunk size in Kb] - read the file by chunks and keep only packets of the trim ranges
+ *   -range <startTime> <endTime> - one more trim range, every range is saved into own fbx
+ *   -template <fbx file> - template scene with the camera animation nodes
+ *   -output <fbx file> - output file, for a batch it's an output directory
+ *   -threads <number> - number of batch worker threads
+ *   -fps <frameRate> - frame rate of batch recordings, which have no frame rate in the manifest, of a capture or a replay
+ *   -index - use a sidecar index <recording>.cgiidx of a binary recording, it's written on the first load
+ *   -window <seconds> - length of the rolling window of a live capture
+ *   -stats <json file> - save statistics of the recording packets, like frame steps, drift and gaps
+ *   -resample <frameRate> [nearest | linear | cubic] - keys on the output frame grid instead of a key per packet, linear by default
+ *   -coords <td | maya | houdini | unreal | unity> - coordinate system of the export target, maya by default
+ *   -lens <calibration file> - lens calibration table of an uncalibrated rig, see CGILensCalibration
+ *   -chip <width> <height> - camera chip size in mm, the FieldOfView curve gets the vertical field of view instead of the focal length
+ *   -filter [cutoff] - low-pass filter of rotation and lens channels, the cutoff frequency in Hz, see CGIFiltering
+ *   -reduce [tolerance scale] - remove keys the curves interpolate within tolerances, see CGIKeyReduction
+ *
+ *  A batch manifest is a text file with a line per recording
+ *   <recording path> [frameRate] [startTime endTime] ...
+ *
+ *  A live address is udp:<port> or serial:<device>[:<baud rate>] for a capture,
+ *  and udp:<host>:<port> or serial:<device>[:<baud rate>] for a replay
+ *
+ * \return
+ */
+int main(int argc, char* argv[]) {
+	printf("Welcome To A Technocrane Trimmer!\n");
+
+#ifndef __EMSCRIPTEN__
+
+	const bool isBatch = (argc >= 3 && strcmp(argv[1], "-batch") == 0);
+	const bool isCapture = (argc >= 3 && strcmp(argv[1], "-capture") == 0);
+	const bool isReplay = (argc >= 4 && strcmp(argv[1], "-replay") == 0);
+	const bool isTrim = !isBatch && !isCapture && !isReplay;
+
+	if (argc < 5 && isTrim)
+	{
+		printf("Wrong number of arguments, please provide\n");
+		printf(" <filename to read (.cgi, .gz or .zip)> <frameRate> <startTime> <endTime> [-stream [chunk size in Kb]] [-range <startTime> <endTime>]\n");
+		printf(" or -batch <directory or manifest file> [-fps <frameRate>] [-threads <number>]\n");
+		printf(" or -capture <udp:port or serial:device> [-fps <frameRate>] [-window <seconds>]\n");
+		printf(" or -replay <filename to read> <udp:host:port or serial:device> [-fps <frameRate>]\n");
+		printf(" common options [-template <fbx file>] [-output <fbx file or directory>] [-index] [-stats <json file>]\n");
+		printf("  [-coords <td | maya | houdini | unreal | unity>] [-lens <calibration file>] [-chip <width mm> <height mm>] [-filter [cutoff Hz]] [-resample <frameRate> [nearest | linear | cubic]] [-reduce [tolerance scale]]\n");
+		return -1;
+	}
+
+	const char* fname{ argv[isTrim ? 1 : 2] };
+
+	double frameRate{ 25.0 }, startTime{ 0.0 }, endTime{ 0.0 };
+	if (isTrim)
+	{
+		sscanf_s(argv[2], "%lf", &frameRate);
+		sscanf_s(argv[3], "%lf", &startTime);
+		sscanf_s(argv[4], "%lf", &endTime);
+	}
+
+	std::vector<std::pair<double, double>> trimRanges(1, std::make_pair(startTime, endTime));
+
+	bool useStream{ false };
+	bool useIndex{ false };
+	size_t streamChunkSize{ 1024 * 1024 };
+
+	std::string templateFilename{ DEFAULT_TEMPLATE_FILENAME };
+	std::string outputFilename;
+	std::string statisticsFilename;
+	size_t numberOfThreads{ GetNumberOfWorkerThreads() };
+	double windowSeconds{ 300.0 };
+	CGICoordinateSystem coordinateSystem{ CGICoordinateSystem::Maya };
+	CGILensCalibration lensCalibration;
+	CGIFiltering filtering;
+	CGIResampling resampling;
+	CGIKeyReduction keyReduction;
+
+	// an option without its values is a wrong command line, like an unknown option
+	auto fn_hasValues = [argc, argv](const int i, const int numberOfValues) -> bool
+		{
+			if (i + numberOfValues < argc)
+				return true;
+
+			printf("Missing a value of the %s option\n", argv[i]);
+			return false;
+		};
+
+	for (int i = (isTrim) ? 5 : ((isReplay) ? 4 : 3); i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-stream") == 0)
+		{
+			useStream = true;
+
+			int chunkSizeKb = 0;
+			if (i + 1 < argc && sscanf_s(argv[i + 1], "%d", &chunkSizeKb) == 1 && chunkSizeKb > 0)
+			{
+				streamChunkSize = static_cast<size_t>(chunkSizeKb) * 1024;
+				++i;
+			}
+		}
+		else if (strcmp(argv[i], "-range") == 0)
+		{
+			double rangeStart, rangeEnd;
+			if (i + 2 < argc && sscanf_s(argv[i + 1], "%lf", &rangeStart) == 1 && sscanf_s(argv[i + 2], "%lf", &rangeEnd) == 1)
+			{
+				trimRanges.emplace_back(rangeStart, rangeEnd);
+				i += 2;
+			}
+			else
+			{
+				printf("Wrong -range arguments, please provide <startTime> <endTime>\n");
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-template") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			templateFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "-output") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			outputFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "-threads") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			int threads = 0;
+			if (sscanf_s(argv[++i], "%d", &threads) != 1 || threads <= 0)
+			{
+				printf("Wrong -threads argument, please provide a number of threads\n");
+				return -1;
+			}
+			numberOfThreads = static_cast<size_t>(threads);
+		}
+		else if (strcmp(argv[i], "-fps") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			if (sscanf_s(argv[++i], "%lf", &frameRate) != 1 || frameRate <= 0.0)
+			{
+				printf("Wrong -fps argument, please provide <frameRate>\n");
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-index") == 0)
+		{
+			useIndex = true;
+		}
+		else if (strcmp(argv[i], "-window") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			if (sscanf_s(argv[++i], "%lf", &windowSeconds) != 1 || windowSeconds <= 0.0)
+			{
+				printf("Wrong -window argument, please provide <seconds>\n");
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-stats") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			statisticsFilename = argv[++i];
+		}
+		else if (strcmp(argv[i], "-resample") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			if (sscanf_s(argv[++i], "%lf", &resampling.frameRate) != 1 || resampling.frameRate <= 0.0)
+			{
+				printf("Wrong -resample arguments, please provide <frameRate> [nearest | linear | cubic]\n");
+				return -1;
+			}
+
+			if (i + 1 < argc && CGIResampling::ParseMethod(argv[i + 1], resampling.method))
+				++i;
+		}
+		else if (strcmp(argv[i], "-coords") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			if (!ParseCoordinateSystem(argv[++i], coordinateSystem))
+			{
+				printf("Wrong -coords argument, please provide td, maya, houdini, unreal or unity\n");
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-lens") == 0)
+		{
+			if (!fn_hasValues(i, 1))
+				return -1;
+			if (!lensCalibration.Load(argv[++i]))
+			{
+				printf("Failed to read the lens calibration file!\n");
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-chip") == 0)
+		{
+			if (!fn_hasValues(i, 2))
+				return -1;
+			if (sscanf_s(argv[i + 1], "%f", &lensCalibration.chipWidth) != 1 || sscanf_s(argv[i + 2], "%f", &lensCalibration.chipHeight) != 1
+				|| !lensCalibration.HasChipSize())
+			{
+				printf("Wrong -chip arguments, please provide <width mm> <height mm>\n");
+				return -1;
+			}
+			i += 2;
+		}
+		else if (strcmp(argv[i], "-filter") == 0)
+		{
+			filtering.isEnabled = true;
+
+			float cutoff = 0.0f;
+			if (i + 1 < argc && sscanf_s(argv[i + 1], "%f", &cutoff) == 1 && cutoff > 0.0f)
+			{
+				filtering.rotation = cutoff;
+				filtering.lens = cutoff;
+				++i;
+			}
+		}
+		else if (strcmp(argv[i], "-reduce") == 0)
+		{
+			keyReduction.isEnabled = true;
+
+			float scale = 0.0f;
+			if (i + 1 < argc && sscanf_s(argv[i + 1], "%f", &scale) == 1 && scale > 0.0f)
+			{
+				keyReduction.Scale(scale);
+				++i;
+			}
+		}
+		else
+		{
+			printf("Unknown option %s\n", argv[i]);
+			return -1;
+		}
+	}
+
+	if (isReplay)
+	{
+		return (ReplayRecording(fname, argv[3], frameRate) >= 0) ? 0 : -1;
+	}
+
+	// the template is parsed once and copied for every export
+	fbx::FBXDocument templateDoc;
+	if (!ImportTemplateDocument(templateDoc, templateFilename.c_str(), false))
+		return -1;
+
+	if (isBatch)
+	{
+		std::vector<BatchJob> jobs;
+		if (!CollectBatchJobs(fname, frameRate, outputFilename, jobs))
+		{
+			printf("Failed to read the batch directory or manifest!\n");
+			return -1;
+		}
+
+		// the exit code is the number of failed recordings
+		return RunBatch(jobs, templateDoc, numberOfThreads, false, useIndex, coordinateSystem, lensCalibration, filtering, resampling, keyReduction);
+	}
+
+	if (outputFilename.empty())
+		outputFilename = DEFAULT_OUTPUT_FILENAME;
+
+	if (isCapture)
+	{
+		return (RunLiveCapture(templateDoc, fname, frameRate, windowSeconds, coordinateSystem, lensCalibration, filtering, resampling, keyReduction, outputFilename, false) >= 0) ? 0 : -1;
+	}
+
+	if (useStream)
+	{
+		return (StreamTrimAndExportToFBX(templateDoc, fname, streamChunkSize, frameRate, trimRanges, coordinateSystem, lensCalibration, filtering, resampling, keyReduction, outputFilename, false) > 0) ? 0 : -1;
+	}
+
+	// packets are viewed directly in the file mapping, keep it until the export is finished
+	MemoryMappedFile file;
+	if (!file.Open(fname))
+	{
+		printf("Failed to read the file!\n");
+		return -1;
+	}
+
+	// load once for both the info and the export
+	CGIConvert cgiConvert;
+	cgiConvert.SetCoordinateSystem(coordinateSystem);
+	cgiConvert.SetLensCalibration(lensCalibration);
+	cgiConvert.SetFiltering(filtering);
+	cgiConvert.SetResampling(resampling);
+	cgiConvert.SetKeyReduction(keyReduction);
+	CGIStatistics statistics;
+	if (useIndex)
+	{
+		if (!LoadRecordingWithIndex(file, fname, frameRate, trimRanges, cgiConvert, statistics, true))
+		{
+			printf("ERROR: Faled to load cgi stream packets or stream has no packets!\n");
+			return -1;
+		}
+	}
+	else
+	{
+		// the statistics file describes the whole recording, a compressed one is not trimmed on the load then
+		const CGIConvert::PacketFilter trimFilter = (statisticsFilename.empty()) ? MakeTrimRangesFilter(frameRate, trimRanges, filtering) : CGIConvert::PacketFilter();
+		if (!cgiConvert.LoadPackets(file.GetData(), file.GetSize(), static_cast<float>(frameRate), trimFilter)
+			|| cgiConvert.IsEmpty())
+		{
+			printf("ERROR: Faled to load cgi stream packets or stream has no packets!\n");
+			return -1;
+		}
+
+		if (trimFilter && CGIInflateStream::IsCompressed(file.GetData(), file.GetSize()))
+			printf("== Trim ranges statistics, the rest of the recording is not loaded ==\n");
+		PrintPacketsInfo(cgiConvert, frameRate, false, statistics);
+	}
+
+	if (!statisticsFilename.empty() && !WriteStatisticsJSON(statisticsFilename.c_str(), statistics, frameRate))
+	{
+		printf("Failed to write the statistics %s\n", statisticsFilename.c_str());
+	}
+
+	ExportRangesToFBX(templateDoc, cgiConvert, frameRate, trimRanges, outputFilename, false, false);
+
+	file.Close();
 #endif
 	return 0;
 }
\ No newline at end of file
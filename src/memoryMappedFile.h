@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// <summary>
+/// Read-only memory mapping of a file on disk
+///  The mapping is advised for a sequential access, pages are loaded by the OS on demand,
+/// so the memory usage and startup time don't grow with a file size
+///  The mapping stays valid until Close() or the object destruction
+/// </summary>
+class MemoryMappedFile
+{
+public:
+
+	MemoryMappedFile() = default;
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile&) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+	/// <summary>
+	/// map the whole file into memory, returns false when file is missing or empty
+	/// </summary>
+	bool Open(const char* filename);
+
+	/// <summary>
+	/// unmap the file view and release OS handles
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return m_Data != nullptr; }
+
+	const uint8_t* GetData() const { return m_Data; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+
+	const uint8_t* m_Data{ nullptr };
+	size_t         m_Size{ 0 };
+
+#ifdef _WIN32
+	void* m_FileHandle{ nullptr };
+	void* m_MappingHandle{ nullptr };
+#else
+	int   m_FileDescriptor{ -1 };
+#endif
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+/// <summary>
+/// the current thread runs ParallelFor ranges on itself, see ParallelForSerialScope
+/// </summary>
+inline bool& IsParallelForSerialThread()
+{
+	static thread_local bool isSerial = false;
+	return isSerial;
+}
+
+/// <summary>
+/// number of worker threads to split a data parallel job into
+///  the web build has no threads, everything is processed on the caller thread
+/// </summary>
+inline size_t GetNumberOfWorkerThreads()
+{
+#ifdef __EMSCRIPTEN__
+	return 1;
+#else
+	if (IsParallelForSerialThread())
+		return 1;
+
+	const unsigned int hardware_threads = std::thread::hardware_concurrency();
+	return (hardware_threads > 0) ? static_cast<size_t>(hardware_threads) : 1;
+#endif
+}
+
+/// <summary>
+/// number of blocks ParallelFor splits a range into, blocks are the same for the same arguments
+/// </summary>
+inline size_t GetNumberOfParallelBlocks(const size_t count, const size_t min_block_size)
+{
+	const size_t max_blocks = std::max<size_t>(1, count / std::max<size_t>(1, min_block_size));
+	return std::min(GetNumberOfWorkerThreads(), max_blocks);
+}
+
+/// <summary>
+/// ParallelFor calls of the current thread run serially while the scope is alive,
+///  a worker of a parallel batch doesn't start nested threads, the batch already uses all cores
+/// </summary>
+class ParallelForSerialScope
+{
+public:
+
+	ParallelForSerialScope()
+		: m_Previous(IsParallelForSerialThread())
+	{
+		IsParallelForSerialThread() = true;
+	}
+
+	~ParallelForSerialScope()
+	{
+		IsParallelForSerialThread() = m_Previous;
+	}
+
+	ParallelForSerialScope(const ParallelForSerialScope&) = delete;
+	ParallelForSerialScope& operator=(const ParallelForSerialScope&) = delete;
+
+private:
+
+	bool	m_Previous;
+};
+
+/// <summary>
+/// split a range [0; count) into contiguous blocks and process them in parallel
+///  a block is not smaller than min_block_size, so small ranges are processed on the caller thread
+///  the function is called as fn(begin, end, block_index)
+/// </summary>
+/// <returns>number of blocks the range is split into</returns>
+template<typename F>
+size_t ParallelFor(const size_t count, const size_t min_block_size, F&& fn)
+{
+	const size_t number_of_blocks = GetNumberOfParallelBlocks(count, min_block_size);
+
+	if (number_of_blocks <= 1)
+	{
+		fn(static_cast<size_t>(0), count, static_cast<size_t>(0));
+		return 1;
+	}
+
+#ifndef __EMSCRIPTEN__
+	const size_t block_size = (count + number_of_blocks - 1) / number_of_blocks;
+
+	std::vector<std::thread> workers;
+	workers.reserve(number_of_blocks - 1);
+
+	for (size_t block = 1; block < number_of_blocks; ++block)
+	{
+		const size_t begin = std::min(count, block * block_size);
+		const size_t end = std::min(count, begin + block_size);
+		workers.emplace_back([&fn, begin, end, block]() { fn(begin, end, block); });
+	}
+
+	// the caller thread takes the first block
+	fn(static_cast<size_t>(0), std::min(count, block_size), static_cast<size_t>(0));
+
+	for (auto& worker : workers)
+		worker.join();
+#endif
+	return number_of_blocks;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stddef.h>
+
+/// <summary>
+/// Lock-free ring buffer for exactly one producer thread and one consumer thread
+///  The producer only writes the tail and the consumer only writes the head, every side keeps
+/// a cached copy of the other side index, so the shared cache lines are touched only when
+/// the cached index says the ring is full (producer) or empty (consumer)
+///  Capacity is rounded up to a power of two
+/// </summary>
+template<typename T>
+class SPSCRingBuffer
+{
+public:
+
+	explicit SPSCRingBuffer(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+
+		m_Items.resize(size);
+		m_Mask = size - 1;
+	}
+
+	SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+	SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+	size_t GetCapacity() const { return m_Items.size(); }
+
+	/// <summary>
+	/// producer side, returns false when the ring is full
+	/// </summary>
+	bool TryPush(const T& value)
+	{
+		const size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_CachedHead == m_Items.size())
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (tail - m_CachedHead == m_Items.size())
+				return false;
+		}
+
+		m_Items[tail & m_Mask] = value;
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// consumer side, pop up to max_count items at once
+	/// </summary>
+	/// <returns>number of popped items, 0 when the ring is empty</returns>
+	size_t PopBulk(T* values, const size_t max_count)
+	{
+		const size_t head = m_Head.load(std::memory_order_relaxed);
+		if (m_CachedTail == head)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (m_CachedTail == head)
+				return 0;
+		}
+
+		const size_t count = std::min(max_count, m_CachedTail - head);
+		for (size_t i = 0; i < count; ++i)
+			values[i] = m_Items[(head + i) & m_Mask];
+
+		m_Head.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	bool TryPop(T& value)
+	{
+		return PopBulk(&value, 1) == 1;
+	}
+
+	/// <summary>
+	/// number of items in the ring, exact only when called from the producer or the consumer thread
+	/// </summary>
+	size_t GetSize() const
+	{
+		return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire);
+	}
+
+private:
+
+	std::vector<T>	m_Items;
+	size_t			m_Mask{ 0 };
+
+	// indices grow without wrapping, a slot is index & mask
+
+	alignas(64) std::atomic<size_t>	m_Head{ 0 };	//!< written by the consumer
+	alignas(64) size_t				m_CachedTail{ 0 };	//!< consumer copy of the tail
+
+	alignas(64) std::atomic<size_t>	m_Tail{ 0 };	//!< written by the producer
+	alignas(64) size_t				m_CachedHead{ 0 };	//!< producer copy of the head
+};